@@ -30,7 +30,7 @@ void bidirectional_stream_copy(Socket &socket) {
         _input,
         Direction::In,
         [&] {
-            _outbound.write(_input.read(_outbound.remaining_capacity()));
+            _outbound.commit_write(_input.read_into(_outbound.reserve_write(_outbound.remaining_capacity())));
             if (_input.eof()) {
                 _outbound.end_input();
             }
@@ -44,7 +44,7 @@ void bidirectional_stream_copy(Socket &socket) {
         Direction::Out,
         [&] {
             const size_t bytes_to_write = min(max_copy_length, _outbound.buffer_size());
-            const size_t bytes_written = socket.write(_outbound.peek_output(bytes_to_write), false);
+            const size_t bytes_written = socket.write(_outbound.peek_views(bytes_to_write), false);
             _outbound.pop_output(bytes_written);
             if (_outbound.eof()) {
                 socket.shutdown(SHUT_WR);
@@ -59,7 +59,7 @@ void bidirectional_stream_copy(Socket &socket) {
         socket,
         Direction::In,
         [&] {
-            _inbound.write(socket.read(_inbound.remaining_capacity()));
+            _inbound.commit_write(socket.read_into(_inbound.reserve_write(_inbound.remaining_capacity())));
             if (socket.eof()) {
                 _inbound.end_input();
             }
@@ -73,7 +73,7 @@ void bidirectional_stream_copy(Socket &socket) {
         Direction::Out,
         [&] {
             const size_t bytes_to_write = min(max_copy_length, _inbound.buffer_size());
-            const size_t bytes_written = _output.write(_inbound.peek_output(bytes_to_write), false);
+            const size_t bytes_written = _output.write(_inbound.peek_views(bytes_to_write), false);
             _inbound.pop_output(bytes_written);
 
             if (_inbound.eof()) {
@@ -0,0 +1,152 @@
+#include "address.hh"
+#include "buffer.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+#include "tcp_sharded_engine.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t CONNECTIONS = 64;
+constexpr size_t BYTES_EACH = 2 * 1024 * 1024;
+constexpr size_t QUEUE_CAPACITY = 1 << 14;  // enough for every connection's window, so the wire never drops
+
+static const Address CLIENT{"10.0.0.1"};
+static const Address SERVER{"10.0.0.2", 80};
+
+// a client connection, and how much it has still to write
+struct Outbound {
+    TCPEngine::ConnectionId id = 0;
+    size_t remaining = BYTES_EACH;
+};
+
+// moves datagrams from one engine to the other until told to stop, through their wire format (as
+// a TUN device would, and because a shard parses each segment from one contiguous buffer); it
+// sleeps until `from`'s workers send something
+static void wire(ShardedTCPEngine &from, ShardedTCPEngine &to, const atomic<bool> &done) {
+    vector<InternetDatagram> datagrams;
+    while (not done) {
+        datagrams.clear();
+        from.egress_wakeup().prepare();
+        if (from.datagrams_out(datagrams) == 0) {
+            from.egress_wakeup().wait(ShardedTCPEngine::MAX_WAIT_MS);
+            continue;
+        }
+        for (const InternetDatagram &dgram : datagrams) {
+            InternetDatagram copy;
+            if (copy.parse(Buffer(dgram.serialize().concatenate())) != ParseResult::NoError) {
+                throw runtime_error("an engine sent a datagram that doesn't parse");
+            }
+            to.datagram_received(move(copy));
+        }
+    }
+}
+
+//! Transfers BYTES_EACH on each of CONNECTIONS connections, between two engines of `workers` shards each
+void transfer(const size_t workers) {
+    TCPConfig cfg{};
+    cfg.mss = TCPConfig::mss_for_mtu(1500);
+
+    const string chunk(cfg.send_capacity, 'x');
+    vector<vector<Outbound>> outbound(workers);
+    ShardedTCPEngine client{workers,
+                            [&](const size_t shard, TCPEngine &engine) {
+                                for (Outbound &conn : outbound[shard]) {
+                                    if (conn.remaining == 0) {
+                                        continue;
+                                    }
+                                    const size_t room = engine.connection(conn.id).remaining_outbound_capacity();
+                                    if (room > 0) {
+                                        const size_t len = min(room, conn.remaining);
+                                        conn.remaining -= engine.write(conn.id, chunk.substr(0, len));
+                                    }
+                                    if (conn.remaining == 0) {
+                                        engine.release(conn.id);
+                                    }
+                                }
+                            },
+                            QUEUE_CAPACITY};
+
+    vector<vector<TCPEngine::ConnectionId>> inbound(workers);
+    atomic<uint64_t> received{0};
+    ShardedTCPEngine server{workers,
+                            [&](const size_t shard, TCPEngine &engine) {
+                                while (const auto id = engine.accept(SERVER.port())) {
+                                    inbound[shard].push_back(*id);
+                                }
+                                for (const TCPEngine::ConnectionId id : inbound[shard]) {
+                                    if (engine.contains(id)) {
+                                        ByteStream &stream = engine.connection(id).inbound_stream();
+                                        received += stream.read(stream.buffer_size()).size();
+                                    }
+                                }
+                            },
+                            QUEUE_CAPACITY};
+    server.listen(cfg, SERVER, CONNECTIONS);
+
+    atomic<bool> done{false};
+    thread to_server([&] { wire(client, server, done); });
+    thread to_client([&] { wire(server, client, done); });
+
+    const auto start = steady_clock::now();
+    for (size_t i = 0; i < CONNECTIONS; i++) {
+        const Address local{CLIENT.ip(), static_cast<uint16_t>(40000 + i)};
+        const size_t shard =
+            client.shard_of({local.ipv4_numeric(), local.port(), SERVER.ipv4_numeric(), SERVER.port()});
+        while (not client.post(shard, [&, shard, local](TCPEngine &engine) {
+            outbound[shard].push_back({engine.connect(cfg, local, SERVER)});
+        })) {
+            this_thread::yield();
+        }
+    }
+
+    const uint64_t total = CONNECTIONS * BYTES_EACH;
+    const auto give_up = start + seconds(120);
+    while (received < total and steady_clock::now() < give_up) {
+        this_thread::sleep_for(milliseconds(1));
+    }
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    done = true;
+    to_server.join();
+    to_client.join();
+    client.stop();
+    server.stop();
+
+    cout << fixed << setprecision(2) << setw(3) << workers << " worker(s) per engine: "
+         << received * 8.0 / double(duration) << " Gbit/s aggregate"
+         << (received < total ? " (gave up)" : "") << ", " << client.dropped() + server.dropped()
+         << " datagrams dropped\n";
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        // up to the given number of workers, or (by default) enough for each engine to have a core
+        // of its own for each, and at least 4
+        const size_t cores = max(thread::hardware_concurrency(), 1u);
+        const size_t max_workers = argc > 1 ? stoul(argv[1]) : max<size_t>(4, cores / 2);
+
+        cout << CONNECTIONS << " connections of " << (BYTES_EACH >> 20) << " MiB each, between two engines, on "
+             << cores << " core(s)\n";
+        for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+            transfer(workers);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -2,8 +2,10 @@
 
 #include <chrono>
 #include <cstdlib>
+#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <new>
 #include <string>
 
 using namespace std;
@@ -11,9 +13,57 @@ using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+// every heap allocation the benchmark makes, so a run can report how many it took per segment
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+//! One benchmark run
+struct Scenario {
+    string name;                  //!< printed before the result
+    size_t stream_len = len;      //!< bytes sent from x to y
+    bool reorder = false;         //!< deliver each batch of segments from x to y in reverse
+    unsigned drop_per_mille = 0;  //!< segments from x to y that are lost, per thousand
+    TCPConfig config{};           //!< used by both connections
+
+    //! If nonzero, each exchange of segments counts as one round trip of this many ms, and the
+    //! goodput over that simulated time is reported instead of the CPU-limited throughput.
+    size_t simulated_rtt_ms = 0;
+};
+
+//! A transfer through a simulated bottleneck link, in steps of one millisecond
+struct BottleneckScenario {
+    string name{};                          //!< printed before the result
+    size_t stream_len = 16 * 1024 * 1024;   //!< bytes sent from x to y
+    double megabits_per_second = 20;        //!< rate of the link from x to y
+    size_t queue_segments = 25;             //!< drop-tail queue in front of the link
+    uint64_t rtt_ms = 20;                   //!< propagation delay there and back, without queueing
+    uint64_t max_ms = 120000;               //!< give up (and report what got through) after this long
+    unsigned drop_per_mille = 0;            //!< segments from x lost at random before the queue, per thousand
+    TCPConfig config{};                     //!< used by both connections
+};
+
+//! \returns the number of segments x sent
+size_t move_segments(TCPConnection &x,
+                     TCPConnection &y,
+                     vector<TCPSegment> &segments,
+                     const bool reorder,
+                     const unsigned drop_per_mille = 0) {
+    const size_t sent = x.segments_out().size();
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        if (drop_per_mille == 0 or unsigned(rand()) % 1000 >= drop_per_mille) {
+            segments.emplace_back(move(x.segments_out().front()));
+        }
         x.segments_out().pop();
     }
     if (reorder) {
@@ -26,13 +76,16 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
         }
     }
     segments.clear();
+    return sent;
 }
 
-void main_loop(const bool reorder) {
-    TCPConfig config;
-    TCPConnection x{config}, y{config};
+void main_loop(const Scenario &scenario) {
+    TCPConnection x{scenario.config}, y{scenario.config};
+
+    const size_t stream_len = scenario.stream_len;
+    const size_t ms_per_round_trip = scenario.simulated_rtt_ms ? scenario.simulated_rtt_ms : 1000;
 
-    string string_to_send(len, 'x');
+    string string_to_send(stream_len, 'x');
     for (auto &ch : string_to_send) {
         ch = rand();
     }
@@ -44,8 +97,10 @@ void main_loop(const bool reorder) {
     bool x_closed = false;
 
     string string_received;
-    string_received.reserve(len);
+    string_received.reserve(stream_len);
 
+    size_t segments_sent = 0;
+    const size_t first_allocations = allocations;
     const auto first_time = high_resolution_clock::now();
 
     auto loop = [&] {
@@ -66,7 +121,7 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
+        segments_sent += move_segments(x, y, segments, scenario.reorder, scenario.drop_per_mille);
         move_segments(y, x, segments, false);
 
         // read output from y
@@ -76,12 +131,14 @@ void main_loop(const bool reorder) {
         }
 
         // time passes
-        x.tick(1000);
-        y.tick(1000);
+        x.tick(ms_per_round_trip);
+        y.tick(ms_per_round_trip);
     };
 
+    size_t round_trips = 0;
     while (not y.inbound_stream().eof()) {
         loop();
+        round_trips++;
     }
 
     if (string_received != string_to_send) {
@@ -89,24 +146,193 @@ void main_loop(const bool reorder) {
     }
 
     const auto final_time = high_resolution_clock::now();
+    const size_t transfer_allocations = allocations - first_allocations;
 
     const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
 
-    const auto gigabits_per_second = len * 8.0 / double(duration);
+    const auto gigabits_per_second = stream_len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << scenario.name;
+    if (scenario.simulated_rtt_ms) {
+        const auto megabits_per_second = stream_len * 8.0 / 1000.0 / double(round_trips * ms_per_round_trip);
+        cout << megabits_per_second << " Mbit/s (" << round_trips << " round trips of " << ms_per_round_trip
+             << " ms)\n";
+    } else {
+        cout << gigabits_per_second << " Gbit/s, " << double(transfer_allocations) / double(segments_sent)
+             << " allocations per segment\n";
+    }
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
+// segments in flight on one direction of the simulated path, with the time each one arrives
+using DelayLine = deque<pair<uint64_t, TCPSegment>>;
+
+//! Runs x -> queue -> link -> y, with y's ACKs coming straight back, each direction delayed by
+//! half the RTT; reports goodput and how long segments waited in the queue
+void bottleneck_loop(const BottleneckScenario &scenario) {
+    TCPConnection x{scenario.config}, y{scenario.config};
+    x.connect();
+    y.end_input_stream();
+
+    Buffer bytes_to_send{string(scenario.stream_len, 'x')};
+    size_t bytes_received = 0;
+    bool x_closed = false;
+
+    const double link_bytes_per_ms = scenario.megabits_per_second * 1000.0 / 8.0;
+    const uint64_t one_way_ms = scenario.rtt_ms / 2;
+
+    deque<pair<uint64_t, TCPSegment>> queue;  // with the time each segment joined it
+    DelayLine to_y, to_x;
+    double link_credit = 0;
+    size_t dropped = 0, carried = 0;
+    uint64_t queueing_ms = 0, max_queueing_ms = 0;
+
+    uint64_t now = 0;
+    for (; not y.inbound_stream().eof() and now < scenario.max_ms; now++) {
+        while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
+            bytes_to_send.remove_prefix(x.write(string(bytes_to_send.str().substr(0, want))));
+        }
+        if (bytes_to_send.size() == 0 and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        // x's segments are lost at random (as through a LossyFdAdapter), or join the queue, or are
+        // dropped if it is full
+        while (not x.segments_out().empty()) {
+            if (scenario.drop_per_mille and unsigned(rand()) % 1000 < scenario.drop_per_mille) {
+                dropped++;
+            } else if (queue.size() < scenario.queue_segments) {
+                queue.emplace_back(now, move(x.segments_out().front()));
+            } else {
+                dropped++;
+            }
+            x.segments_out().pop();
+        }
+
+        // the link sends as many whole segments (with 40 bytes of headers) as its rate allows
+        link_credit += link_bytes_per_ms;
+        while (not queue.empty() and link_credit >= queue.front().second.payload().size() + 40) {
+            link_credit -= queue.front().second.payload().size() + 40;
+            const uint64_t waited = now - queue.front().first;
+            queueing_ms += waited;
+            max_queueing_ms = max(max_queueing_ms, waited);
+            carried++;
+            to_y.emplace_back(now + one_way_ms, move(queue.front().second));
+            queue.pop_front();
+        }
+        if (queue.empty()) {
+            link_credit = min(link_credit, link_bytes_per_ms);
+        }
+
+        while (not to_y.empty() and to_y.front().first <= now) {
+            y.segment_received(to_y.front().second);
+            to_y.pop_front();
+        }
+        while (not y.segments_out().empty()) {
+            to_x.emplace_back(now + one_way_ms, move(y.segments_out().front()));
+            y.segments_out().pop();
+        }
+        while (not to_x.empty() and to_x.front().first <= now) {
+            x.segment_received(to_x.front().second);
+            to_x.pop_front();
+        }
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        bytes_received += y.inbound_stream().read(available_output).size();
+
+        x.tick(1);
+        y.tick(1);
+    }
+
+    cout << fixed << setprecision(2) << scenario.name << bytes_received * 8.0 / 1000.0 / double(now) << " Mbit/s, "
+         << (carried ? double(queueing_ms) / double(carried) : 0.0) << " ms average / " << max_queueing_ms
+         << " ms max queueing delay, " << dropped << " segments dropped"
+         << (y.inbound_stream().eof() ? "" : " (gave up)") << "\n";
+}
+
 int main() {
     try {
-        main_loop(false);
-        main_loop(true);
+        main_loop({"CPU-limited throughput                : "});
+        main_loop({"CPU-limited throughput with reordering: ", len, true});
+
+        // the largest MSS a 1500-byte MTU allows, instead of the conservative default
+        Scenario ethernet_mss{"CPU-limited throughput, 1460-byte MSS : "};
+        ethernet_mss.config.mss = TCPConfig::mss_for_mtu(1500);
+        main_loop(ethernet_mss);
+
+        // each round trip counts as 100 ms (a tenth of the initial RTO), so losses that the
+        // sender can only detect by timing out are expensive
+        Scenario lossy{"Goodput with 1% loss:                    ", 10 * 1024 * 1024, false, 10};
+        lossy.simulated_rtt_ms = 100;
+        main_loop(lossy);
+        lossy.name = "Goodput with 1% loss and fast retransmit: ";
+        lossy.config.fast_retransmit = true;
+        main_loop(lossy);
+        lossy.name = "Goodput with 1% loss and SACK:           ";
+        lossy.config.fast_retransmit = false;
+        lossy.config.sack = true;
+        main_loop(lossy);
+
+        // with a 50 ms round trip, throughput is bounded by the window; without window scaling
+        // no more than 64 KiB can be advertised, however large the buffers are
+        for (const size_t capacity : {64000ul, 1ul << 20, 4ul << 20, 16ul << 20}) {
+            for (const bool window_scaling : {false, true}) {
+                if (capacity < UINT16_MAX and window_scaling) {
+                    continue;
+                }
+                string name = "Goodput with 50 ms RTT, " + to_string(capacity >> 10) + " KiB buffers" +
+                              (window_scaling ? ", scaled:" : ":");
+                name.resize(50, ' ');
+                Scenario delayed{name, 64 * 1024 * 1024};
+                delayed.simulated_rtt_ms = 50;
+                delayed.config.recv_capacity = delayed.config.send_capacity = capacity;
+                delayed.config.window_scaling = window_scaling;
+                main_loop(delayed);
+            }
+        }
+
+        // a 20 Mbit/s link with a 20 ms RTT (a BDP of about 50 segments), behind a queue of half a
+        // BDP or a shallow one of 5 segments, with buffers large enough that the receiver's window
+        // doesn't hold the sender back
+        const pair<CongestionControl::Algorithm, string> algorithms[] = {
+            {CongestionControl::Algorithm::None, "none"},
+            {CongestionControl::Algorithm::NewReno, "NewReno"},
+            {CongestionControl::Algorithm::Cubic, "CUBIC"},
+            {CongestionControl::Algorithm::BBR, "BBR"}};
+        for (const size_t queue : {25ul, 5ul}) {
+            for (const auto &[algorithm, algorithm_name] : algorithms) {
+                BottleneckScenario shared;
+                shared.name = "20 Mbit/s bottleneck, " + to_string(queue) + "-segment queue, " + algorithm_name + ":";
+                shared.name.resize(50, ' ');
+                shared.queue_segments = queue;
+                shared.config.recv_capacity = shared.config.send_capacity = 1 << 20;
+                shared.config.window_scaling = true;
+                shared.config.sack = true;
+                shared.config.congestion_control = algorithm;
+                bottleneck_loop(shared);
+            }
+        }
+
+        // the same link, with a deep queue but 1% of segments lost at random: NewReno alone can
+        // only find each loss by timing out, fast retransmit finds it from the duplicate ACKs
+        for (const bool fast_retransmit : {false, true}) {
+            BottleneckScenario lossy_link;
+            lossy_link.name = string{"20 Mbit/s bottleneck, 1% loss, NewReno"} + (fast_retransmit ? ", fast rtx:" : ":");
+            lossy_link.name.resize(50, ' ');
+            lossy_link.queue_segments = 50;
+            lossy_link.drop_per_mille = 10;
+            lossy_link.config.recv_capacity = lossy_link.config.send_capacity = 1 << 20;
+            lossy_link.config.window_scaling = true;
+            lossy_link.config.congestion_control = CongestionControl::Algorithm::NewReno;
+            lossy_link.config.fast_retransmit = fast_retransmit;
+            bottleneck_loop(lossy_link);
+        }
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
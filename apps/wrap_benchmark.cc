@@ -0,0 +1,101 @@
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// unwrap() as it was before it became constexpr: floating-point bounds, and a branch on the checkpoint
+static uint64_t legacy_unwrap(WrappingInt32 n, WrappingInt32 isn, uint64_t checkpoint) {
+    uint32_t offset = n.raw_value() - isn.raw_value();
+    if (checkpoint < pow(2, 31)) {
+        return offset;
+    }
+    uint64_t unwrapped = (checkpoint >> 32) << 32;
+    unwrapped += offset;
+    uint64_t power = pow(2, 31);
+    if (unwrapped > checkpoint) {
+        if (unwrapped - checkpoint > power) {
+            unwrapped -= static_cast<uint64_t>(1) << 32;
+        }
+    } else {
+        if (checkpoint - unwrapped > power) {
+            unwrapped += static_cast<uint64_t>(1) << 32;
+        }
+    }
+    return unwrapped;
+}
+
+constexpr size_t BATCH = 4096;
+constexpr size_t ROUNDS = 10000;
+
+//! Seqnos near a checkpoint, as a receiver sees them (a checkpoint below 2^31 takes the legacy fast path)
+struct Workload {
+    string name;
+    uint64_t checkpoint;
+};
+
+template <typename Unwrap>
+static void run(const string &name, const vector<WrappingInt32> &seqnos, const WrappingInt32 isn,
+                const uint64_t checkpoint, Unwrap &&unwrap_batch) {
+    vector<uint64_t> out(seqnos.size());
+    uint64_t sum = 0;
+    const auto start = steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; round++) {
+        unwrap_batch(seqnos, isn, checkpoint + round, out);
+        sum += out[round % out.size()];
+    }
+    const double ns = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    cout << "    " << left << setw(10) << name << fixed << setprecision(2) << ns / (ROUNDS * seqnos.size())
+         << " ns/seqno  (checksum " << sum % 1000 << ")\n";
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const WrappingInt32 isn{static_cast<uint32_t>(rd())};
+
+        for (const Workload &workload : {Workload{"checkpoint below 2^31", 1000},
+                                         Workload{"checkpoint at 2^40", uint64_t{1} << 40}}) {
+            // seqnos within a window of 1 MiB either side of the checkpoint
+            vector<WrappingInt32> seqnos;
+            for (size_t i = 0; i < BATCH; i++) {
+                seqnos.push_back(wrap(workload.checkpoint + rd() % (2 << 20) - (1 << 20), isn));
+            }
+
+            for (const WrappingInt32 seqno : seqnos) {
+                if (unwrap(seqno, isn, workload.checkpoint) != legacy_unwrap(seqno, isn, workload.checkpoint)) {
+                    throw runtime_error("unwrap() disagrees with the legacy implementation");
+                }
+            }
+
+            cout << workload.name << ":\n";
+            run("legacy", seqnos, isn, workload.checkpoint, [](const auto &in, auto i, auto c, auto &out) {
+                for (size_t k = 0; k < in.size(); k++) {
+                    out[k] = legacy_unwrap(in[k], i, c);
+                }
+            });
+            run("unwrap", seqnos, isn, workload.checkpoint, [](const auto &in, auto i, auto c, auto &out) {
+                for (size_t k = 0; k < in.size(); k++) {
+                    out[k] = unwrap(in[k], i, c);
+                }
+            });
+            run("batched", seqnos, isn, workload.checkpoint, [](const auto &in, auto i, auto c, auto &out) {
+                unwrap(in, i, c, out);
+            });
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -3,63 +3,274 @@
  * Filename: byte_stream.cc
  * Author: Maggie Gray
  * Description: This file implements a bytestream that users can write into
- * and read from.
+ * and read from. Bytes are kept in a fixed-capacity circular buffer so that
+ * writes are bulk copies and pops are O(1).
  *
  * */
 
 #include "byte_stream.hh"
 
-#include <iostream>
+#include <algorithm>
+#include <cstring>
 
 using namespace std;
 
+/*
+ *
+ * Function Name: write_contiguous
+ * Args: string_view data
+ * Return: size_t, number of bytes written
+ * Description: This function copies as much of data as fits into the
+ * circular buffer. The copy is done with at most two memcpy calls: one up
+ * to the end of the buffer and one for the part that wraps around to the front.
+ *
+ * */
+size_t ByteStream::write_contiguous(string_view data) {
+    reservedBytes = 0;
+    const size_t numWritten = min(data.size(), remaining_capacity());
+    if (numWritten == 0) {
+        return 0;
+    }
+
+    // the first free slot comes right after the last buffered byte
+    const size_t tail = (head + bufferedBytes) % _capacity;
+    const size_t firstChunk = min(numWritten, _capacity - tail);
+    memcpy(buffer.data() + tail, data.data(), firstChunk);
+    memcpy(buffer.data(), data.data() + firstChunk, numWritten - firstChunk);
+
+    bufferedBytes += numWritten;
+    bytesWritten += numWritten;
+    return numWritten;
+}
+
 /*
  *
  * Function Name: write
  * Args: const string &data
  * Return: size_t, number of bytes written
- * Description: This function takes a string of data
- * and stores it in the string "input" if the bytestream
- * has capacity left to store data.
+ * Description: This function takes a string of data and stores as much
+ * of it as the bytestream has capacity for.
  *
  * */
 size_t ByteStream::write(const string &data) {
-    size_t numWritten = 0;
-
-    // add each character in the data string to the input string
-    // if the bytestream has capacity left
-    for (int i = 0; i < static_cast<int>(data.length()); i++) {
-        if (capacityLeft > 0) {
-            input += data[i];
-            numWritten++;
-            capacityLeft--;
-        }
+    if (storage == Storage::Contiguous) {
+        return write_contiguous(data);
+    }
+
+    // in Chunked mode the string has to be copied once into a Buffer we own
+    const size_t numWritten = min(data.size(), remaining_capacity());
+    if (numWritten == 0) {
+        return 0;
     }
+    chunks.append(Buffer(data.substr(0, numWritten)));
+    bufferedBytes += numWritten;
     bytesWritten += numWritten;
     return numWritten;
 }
 
+/*
+ *
+ * Function Name: write
+ * Args: Buffer data
+ * Return: size_t, number of bytes written
+ * Description: This function takes a Buffer and stores as much of it as
+ * the bytestream has capacity for. In Chunked mode a Buffer that fits
+ * entirely is kept by reference, so its bytes are never copied.
+ *
+ * */
+size_t ByteStream::write(Buffer data) {
+    if (storage == Storage::Contiguous) {
+        return write_contiguous(data.str());
+    }
+
+    const size_t numWritten = min(data.size(), remaining_capacity());
+    if (numWritten == 0) {
+        return 0;
+    }
+
+    // a partial write keeps a slice of the prefix, still without copying
+    if (numWritten == data.size()) {
+        chunks.append(move(data));
+    } else {
+        chunks.append(data.slice(0, numWritten));
+    }
+    bufferedBytes += numWritten;
+    bytesWritten += numWritten;
+    return numWritten;
+}
+
+/*
+ *
+ * Function Name: reserve_write
+ * Args: const size_t len
+ * Return: vector<iovec>, the free regions a writer may fill
+ * Description: This function hands out up to len bytes of free space so the
+ * caller can write into the stream without an intermediate string. In
+ * Contiguous mode these are the (at most two) free regions of the circular
+ * buffer; in Chunked mode a new chunk is allocated to be filled in.
+ *
+ * */
+vector<iovec> ByteStream::reserve_write(const size_t len) {
+    const size_t numReserved = min(len, remaining_capacity());
+    reservedBytes = numReserved;
+    vector<iovec> regions;
+    if (numReserved == 0) {
+        return regions;
+    }
+
+    if (storage == Storage::Chunked) {
+        pendingChunk.resize(numReserved);
+        regions.push_back({pendingChunk.data(), numReserved});
+        return regions;
+    }
+
+    const size_t tail = (head + bufferedBytes) % _capacity;
+    const size_t firstChunk = min(numReserved, _capacity - tail);
+    regions.push_back({buffer.data() + tail, firstChunk});
+    if (numReserved > firstChunk) {
+        regions.push_back({buffer.data(), numReserved - firstChunk});
+    }
+    return regions;
+}
+
+//! \param[in] len bytes, already placed in the reserved regions, will be added to the stream
+void ByteStream::commit_write(const size_t len) {
+    const size_t numWritten = min({len, reservedBytes, remaining_capacity()});
+    reservedBytes = 0;
+
+    if (storage == Storage::Chunked) {
+        pendingChunk.resize(min(numWritten, pendingChunk.size()));
+        if (!pendingChunk.empty()) {
+            bufferedBytes += pendingChunk.size();
+            bytesWritten += pendingChunk.size();
+            chunks.append(Buffer(move(pendingChunk)));
+        }
+        pendingChunk = {};
+        return;
+    }
+
+    bufferedBytes += numWritten;
+    bytesWritten += numWritten;
+}
+
+/*
+ *
+ * Function Name: set_capacity
+ * Args: const size_t capacity
+ * Return: size_t, the capacity now in effect
+ * Description: This function grows or shrinks the bytestream, but never below
+ * the number of bytes it is holding. In Contiguous mode the buffered bytes are
+ * copied (in at most two memcpy calls) to the front of a new buffer of the new
+ * size; in Chunked mode only the limit changes.
+ *
+ * */
+size_t ByteStream::set_capacity(const size_t capacity) {
+    const size_t newCapacity = max(capacity, bufferedBytes);
+    if (storage == Storage::Contiguous && newCapacity != _capacity) {
+        reservedBytes = 0;
+        string resized(newCapacity, '\0');
+        const size_t firstChunk = min(bufferedBytes, _capacity - head);
+        memcpy(resized.data(), buffer.data() + head, firstChunk);
+        memcpy(resized.data() + firstChunk, buffer.data(), bufferedBytes - firstChunk);
+        buffer.swap(resized);
+        head = 0;
+    }
+    _capacity = newCapacity;
+    return _capacity;
+}
+
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
-    // check to see if there are len bytes left in input
-    if (input.length() < len) {
-        return input;
+    const size_t numPeeked = min(len, bufferedBytes);
+    if (numPeeked == 0) {
+        return {};
     }
-    return input.substr(0, len);
+
+    string output;
+    output.reserve(numPeeked);
+
+    if (storage == Storage::Chunked) {
+        // concatenate chunks from the front until we have enough bytes
+        for (const auto &chunk : chunks.buffers()) {
+            const size_t needed = numPeeked - output.size();
+            if (needed == 0) {
+                break;
+            }
+            output.append(chunk.str().substr(0, needed));
+        }
+        return output;
+    }
+
+    // copy the bytes up to the end of the buffer, then any that wrapped around
+    const size_t firstChunk = min(numPeeked, _capacity - head);
+    output.append(buffer, head, firstChunk);
+    output.append(buffer, 0, numPeeked - firstChunk);
+    return output;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    // check to see if there are len bytes left in input
-    if (input.length() < len) {
-        input = "";
-        bytesRead += input.length();
-        capacityLeft += input.length();
+    // popping only moves the read position (or drops chunk references), no bytes are copied
+    const size_t numPopped = min(len, bufferedBytes);
+    if (numPopped == 0) {
+        return;
+    }
+    if (storage == Storage::Chunked) {
+        chunks.remove_prefix(numPopped);
     } else {
-        input = input.substr(len, input.length() - len);
-        bytesRead += len;
-        capacityLeft += len;
+        head = (head + numPopped) % _capacity;
+    }
+    bufferedBytes -= numPopped;
+    bytesRead += numPopped;
+}
+
+BufferList ByteStream::peek_buffers() const {
+    if (storage == Storage::Chunked) {
+        return chunks;
+    }
+    return BufferList(peek_output(bufferedBytes));
+}
+
+//! \param[in] len bytes will be copied (or shared) from the output side of the buffer
+Buffer ByteStream::peek_buffer(const size_t len) const {
+    const size_t numPeeked = min(len, bufferedBytes);
+    if (numPeeked == 0) {
+        return {};
+    }
+    if (storage == Storage::Chunked && chunks.buffers().front().size() >= numPeeked) {
+        return chunks.buffers().front().slice(0, numPeeked);
+    }
+    return Buffer(peek_output(numPeeked));
+}
+
+//! \param[in] len bytes will be exposed from the output side of the buffer
+BufferViewList ByteStream::peek_views(const size_t len) const {
+    const size_t numPeeked = min(len, bufferedBytes);
+    deque<string_view> views;
+    if (numPeeked == 0) {
+        return views;
+    }
+
+    if (storage == Storage::Chunked) {
+        // one view per chunk, the last one cut short if needed
+        size_t remaining = numPeeked;
+        for (const auto &chunk : chunks.buffers()) {
+            if (remaining == 0) {
+                break;
+            }
+            views.push_back(chunk.str().substr(0, remaining));
+            remaining -= views.back().size();
+        }
+        return views;
+    }
+
+    // at most two views: up to the end of the buffer, then the part that wrapped around
+    const size_t firstChunk = min(numPeeked, _capacity - head);
+    views.emplace_back(buffer.data() + head, firstChunk);
+    if (numPeeked > firstChunk) {
+        views.emplace_back(buffer.data(), numPeeked - firstChunk);
     }
+    return views;
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
@@ -75,7 +286,7 @@ void ByteStream::end_input() { inputEnded = true; }
 
 bool ByteStream::input_ended() const { return inputEnded; }
 
-size_t ByteStream::buffer_size() const { return input.length(); }
+size_t ByteStream::buffer_size() const { return bufferedBytes; }
 
 bool ByteStream::buffer_empty() const { return (buffer_size() == 0); }
 
@@ -85,4 +296,4 @@ size_t ByteStream::bytes_written() const { return bytesWritten; }
 
 size_t ByteStream::bytes_read() const { return bytesRead; }
 
-size_t ByteStream::remaining_capacity() const { return capacityLeft; }
+size_t ByteStream::remaining_capacity() const { return _capacity - bufferedBytes; }
@@ -10,7 +10,12 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
 #include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include <vector>
 
 //! \brief An in-order byte stream.
 
@@ -18,14 +23,41 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! How the stream stores the bytes written into it
+    enum class Storage {
+        Contiguous,  //!< Copy bytes into a fixed-capacity circular buffer
+        Chunked      //!< Keep references to the written Buffers, without copying their bytes
+    };
+
   private:
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
-    // the number of bytes left that can be written to the bytestream
-    size_t capacityLeft;
+    // the maximum number of bytes the bytestream can hold at once
+    size_t _capacity;
+
+    // which storage engine the bytestream uses
+    Storage storage;
+
+    // circular storage for bytes that have been written but not yet read, allocated at
+    // construction and again only if set_capacity() changes its size
+    std::string buffer;
 
-    // storage for the writer's input into the bytestream
-    std::string input;
+    // index into buffer of the next byte to be read
+    size_t head;
+
+    // in Chunked mode, the Buffer slices that have been written but not yet read
+    BufferList chunks;
+
+    // in Chunked mode, storage handed out by reserve_write() and not yet committed
+    std::string pendingChunk;
+
+    // bytes the last reserve_write() handed out, the most commit_write() may add; a write or
+    // resize in between moves the free space, so it cancels the reservation (Contiguous mode)
+    size_t reservedBytes;
+
+    // number of bytes currently stored in buffer
+    size_t bufferedBytes;
 
     // checks whether or not the writer has stopped writing
     bool inputEnded;
@@ -34,10 +66,25 @@ class ByteStream {
     size_t bytesRead;
     size_t bytesWritten;
 
+    // copies bytes into the circular buffer (Contiguous mode)
+    size_t write_contiguous(std::string_view data);
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity)
-        : capacityLeft(capacity), input{""}, inputEnded{false}, bytesRead{0}, bytesWritten{0} {}
+    //! \note In Chunked mode no storage is allocated up front; each write keeps a
+    //! reference to the caller's Buffer instead.
+    ByteStream(const size_t capacity, const Storage storage_type = Storage::Contiguous)
+        : _capacity(capacity)
+        , storage(storage_type)
+        , buffer(storage_type == Storage::Contiguous ? capacity : 0, '\0')
+        , head(0)
+        , chunks()
+        , pendingChunk()
+        , reservedBytes(0)
+        , bufferedBytes(0)
+        , inputEnded{false}
+        , bytesRead{0}
+        , bytesWritten{0} {}
 
     //! \name "Input" interface for the writer
     //!@{
@@ -47,9 +94,32 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a Buffer of bytes into the stream. In Chunked mode the stream shares
+    //! the Buffer's storage rather than copying it, unless only part of it fits.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
+    //! Expose up to `len` bytes of free space in the stream so that a writer
+    //! (e.g. [readv(2)](\ref man2::readv)) can fill it in place
+    //! \returns the writable regions, in stream order
+    //! \note Nothing is written until commit_write() is called.
+    std::vector<iovec> reserve_write(const size_t len);
+
+    //! Mark the first `len` bytes of the last reserve_write() regions as written
+    //! \note No more than were reserved are added, so unfilled storage never becomes stream data.
+    void commit_write(const size_t len);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
+    //! \returns the maximum number of bytes the stream can hold at once
+    size_t capacity() const { return _capacity; }
+
+    //! Change the capacity, though never to less than the bytes already buffered
+    //! \returns the capacity now in effect
+    //! \note In Contiguous mode the buffered bytes are copied into a new buffer of the new size.
+    size_t set_capacity(const size_t capacity);
+
     //! Signal that the byte stream has reached its ending
     void end_input();
 
@@ -67,6 +137,21 @@ class ByteStream {
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
+    //! Peek at every byte currently in the stream as a list of Buffers
+    //! \note Shares storage with the stream in Chunked mode; in Contiguous mode the
+    //! bytes are copied into a single Buffer.
+    BufferList peek_buffers() const;
+
+    //! Peek at the next "len" bytes of the stream as a single Buffer
+    //! \note Shares storage with the stream if the bytes lie within one chunk (Chunked mode);
+    //! otherwise they are copied, with one allocation, into a new Buffer.
+    Buffer peek_buffer(const size_t len) const;
+
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns views into the stream's own storage, suitable for [writev(2)](\ref man2::writev)
+    //! \note The views are invalidated by the next call to write() or pop_output().
+    BufferViewList peek_views(const size_t len) const;
+
     //! Read (i.e., copy and then pop) the next "len" bytes of the stream
     //! \returns a string
     std::string read(const size_t len);
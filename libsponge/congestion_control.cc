@@ -0,0 +1,343 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//! \param[in] algorithm which controller to make
+//! \param[in] mss the sender's maximum segment size
+unique_ptr<CongestionControl> CongestionControl::make(const Algorithm algorithm, const size_t mss) {
+    switch (algorithm) {
+        case Algorithm::NewReno:
+            return make_unique<NewReno>(mss);
+        case Algorithm::Cubic:
+            return make_unique<Cubic>(mss);
+        case Algorithm::BBR:
+            return make_unique<BBR>(mss);
+        case Algorithm::None:
+            break;
+    }
+    return nullptr;
+}
+
+NewReno::NewReno(const size_t mss)
+    : CongestionControl(mss), _cwnd(INITIAL_WINDOW * mss), ssthresh(UINT64_MAX), ackedSinceGrowth(0) {}
+
+/*
+ * Function Name: on_ack
+ * Args: const AckSample &sample
+ * Description: This function grows the window. In slow start cwnd grows by the bytes
+ * acknowledged, at most 2 * MSS per ACK (appropriate byte counting, RFC 3465). Above
+ * ssthresh it grows by one MSS for every cwnd bytes acknowledged, i.e. once per round
+ * trip. The window does not grow while a loss is being repaired.
+ */
+void NewReno::on_ack(const AckSample &sample) {
+    if (sample.in_recovery) {
+        return;
+    }
+
+    if (_cwnd < ssthresh) {
+        _cwnd += min(sample.acked_bytes, uint64_t{2 * _mss});
+        return;
+    }
+
+    ackedSinceGrowth += sample.acked_bytes;
+    if (ackedSinceGrowth >= _cwnd) {
+        ackedSinceGrowth -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+//! \details Halves the window, but to no less than two segments (RFC 5681 equation 4)
+void NewReno::on_loss(const uint64_t bytes_in_flight, const uint64_t) {
+    ssthresh = max(bytes_in_flight / 2, uint64_t{2 * _mss});
+    _cwnd = ssthresh;
+    ackedSinceGrowth = 0;
+}
+
+//! \details Sets ssthresh as for a loss, and goes back to slow start from one segment
+void NewReno::on_timeout(const uint64_t bytes_in_flight, const uint64_t) {
+    ssthresh = max(bytes_in_flight / 2, uint64_t{2 * _mss});
+    _cwnd = _mss;
+    ackedSinceGrowth = 0;
+}
+
+Cubic::Cubic(const size_t mss)
+    : CongestionControl(mss)
+    , _cwnd(INITIAL_WINDOW)
+    , ssthresh(HUGE_VAL)
+    , wMax(0)
+    , wLastMax(0)
+    , epochStart()
+    , k(0)
+    , wEst(0)
+    , minRtt() {}
+
+/*
+ * Function Name: on_ack
+ * Args: const AckSample &sample
+ * Description: This function grows the window. Slow start is the same as NewReno's.
+ * In congestion avoidance the window heads for W_cubic(t + RTT) = C (t + RTT - K)^3 + wMax
+ * (RFC 9438 section 4.2), where t is the time since the epoch started, but never grows
+ * by more than half per round trip, and never falls behind the window standard TCP
+ * would have (wEst).
+ */
+void Cubic::on_ack(const AckSample &sample) {
+    if (sample.rtt) {
+        minRtt = minRtt ? min(*minRtt, *sample.rtt) : *sample.rtt;
+    }
+    if (sample.in_recovery) {
+        return;
+    }
+
+    const double acked = static_cast<double>(sample.acked_bytes) / _mss;
+    if (_cwnd < ssthresh) {
+        _cwnd += min(acked, 2.0);
+        return;
+    }
+
+    if (!epochStart) {
+        epochStart = sample.now;
+        if (_cwnd < wMax) {
+            k = cbrt((wMax - _cwnd) / C);
+        } else {
+            k = 0;
+            wMax = _cwnd;
+        }
+        wEst = _cwnd;
+    }
+
+    const double t = static_cast<double>(sample.now - *epochStart + minRtt.value_or(0)) / 1000.0;
+    double target = C * pow(t - k, 3.0) + wMax;
+    target = clamp(target, _cwnd, 1.5 * _cwnd);
+
+    // standard TCP's window grows by 3 (1 - BETA) / (1 + BETA) segments per round trip
+    wEst += 3.0 * (1.0 - BETA) / (1.0 + BETA) * acked / _cwnd;
+    if (wEst > target) {
+        target = wEst;
+    }
+
+    _cwnd += (target - _cwnd) * acked / _cwnd;
+}
+
+/*
+ * Function Name: reduce
+ * Description: This function remembers the window the loss happened at in wMax (lowered
+ * further if the window had not got back to the previous wMax, so that a new flow can
+ * catch up: "fast convergence") and shrinks the window by BETA. The next ACK in
+ * congestion avoidance starts a new epoch.
+ */
+void Cubic::reduce() {
+    wLastMax = wMax;
+    wMax = _cwnd < wLastMax ? _cwnd * (1.0 + BETA) / 2.0 : _cwnd;
+    ssthresh = max(_cwnd * BETA, 2.0);
+    epochStart.reset();
+}
+
+void Cubic::on_loss(const uint64_t, const uint64_t) {
+    reduce();
+    _cwnd = ssthresh;
+}
+
+void Cubic::on_timeout(const uint64_t, const uint64_t) {
+    reduce();
+    _cwnd = 1;
+}
+
+BBR::BBR(const size_t mss)
+    : CongestionControl(mss)
+    , _mode(Mode::Startup)
+    , _cwnd(INITIAL_WINDOW * mss)
+    , pacingRate(0)
+    , pacingGain(HIGH_GAIN)
+    , cwndGain(HIGH_GAIN)
+    , roundCount(0)
+    , nextRoundDelivered(0)
+    , roundStart(false)
+    , bwSamples()
+    , minRtt()
+    , minRttStamp(0)
+    , fullBw(0)
+    , fullBwRounds(0)
+    , filledPipe(false)
+    , cycleIndex(0)
+    , cycleStart(0)
+    , probeRttDoneAt()
+    , probeRttRoundDone(false)
+    , priorCwnd(0) {}
+
+uint64_t BBR::bottleneck_bandwidth() const { return *max_element(bwSamples.begin(), bwSamples.end()); }
+
+optional<uint64_t> BBR::pacing_rate() const {
+    if (pacingRate == 0) {
+        return {};
+    }
+    return pacingRate;
+}
+
+//! \returns `gain` times the estimated bandwidth-delay product, but at least MIN_CWND_SEGMENTS
+//! segments, or no limit at all before the first estimate
+uint64_t BBR::target_cwnd(const double gain) const {
+    const uint64_t bw = bottleneck_bandwidth();
+    if (bw == 0 or not minRtt) {
+        return UINT64_MAX;
+    }
+    const auto bdp = static_cast<uint64_t>(gain * bw * *minRtt / 1000.0);
+    return max(bdp, uint64_t{MIN_CWND_SEGMENTS * _mss});
+}
+
+void BBR::enter_probe_bw(const uint64_t now) {
+    _mode = Mode::ProbeBW;
+    cwndGain = 2;
+    cycleIndex = 0;
+    cycleStart = now;
+    pacingGain = PROBE_BW_GAINS[cycleIndex];
+}
+
+/*
+ * Function Name: on_ack
+ * Args: const AckSample &sample
+ * Description: This function updates the path model (bandwidth, min RTT, round trips)
+ * from the ACK, moves between modes, and then sets the pacing rate and window from the
+ * model.
+ */
+void BBR::on_ack(const AckSample &sample) {
+    update_model(sample);
+    update_mode(sample);
+    update_cwnd(sample);
+
+    // in Startup the rate only goes up, so one slow round trip doesn't hold it back
+    const uint64_t bw = bottleneck_bandwidth();
+    uint64_t rate = static_cast<uint64_t>(pacingGain * bw);
+    if (bw == 0 and minRtt) {
+        // no bandwidth sample yet: send the initial window over one RTT, at the Startup gain
+        rate = static_cast<uint64_t>(HIGH_GAIN * _cwnd * 1000 / *minRtt);
+    }
+    if (filledPipe or rate > pacingRate) {
+        pacingRate = rate;
+    }
+}
+
+/*
+ * Function Name: update_model
+ * Args: const AckSample &sample
+ * Description: This function counts round trips, adds the ACK's delivery rate to the
+ * bandwidth filter (unless the sender was app-limited and the rate is lower than what
+ * the filter already holds), updates the min RTT, and checks whether Startup has filled
+ * the pipe.
+ */
+void BBR::update_model(const AckSample &sample) {
+    roundStart = false;
+    if (sample.prior_delivered >= nextRoundDelivered) {
+        nextRoundDelivered = sample.delivered;
+        roundCount++;
+        roundStart = true;
+        bwSamples[roundCount % BW_WINDOW_ROUNDS] = 0;
+    }
+
+    if (sample.delivery_rate and (not sample.app_limited or *sample.delivery_rate >= bottleneck_bandwidth())) {
+        auto &slot = bwSamples[roundCount % BW_WINDOW_ROUNDS];
+        slot = max(slot, *sample.delivery_rate);
+    }
+
+    if (roundStart and not filledPipe and not sample.app_limited) {
+        const uint64_t bw = bottleneck_bandwidth();
+        if (bw >= fullBw + fullBw / 4) {
+            fullBw = bw;
+            fullBwRounds = 0;
+        } else if (++fullBwRounds >= 3) {
+            filledPipe = true;
+        }
+    }
+
+    const bool minRttExpired = sample.now > minRttStamp + MIN_RTT_WINDOW_MS;
+    if (sample.rtt and (not minRtt or *sample.rtt <= *minRtt or minRttExpired)) {
+        // the clock ticks in ms, so a shorter RTT still counts as 1 ms
+        minRtt = max(*sample.rtt, uint64_t{1});
+        minRttStamp = sample.now;
+    }
+    if (minRttExpired and _mode != Mode::ProbeRTT) {
+        _mode = Mode::ProbeRTT;
+        pacingGain = 1;
+        cwndGain = 1;
+        priorCwnd = _cwnd;
+        probeRttDoneAt.reset();
+    }
+}
+
+/*
+ * Function Name: update_mode
+ * Args: const AckSample &sample
+ * Description: This function moves Startup to Drain once the pipe is full, Drain to
+ * ProbeBW once no more than one BDP is in flight, through ProbeBW's gain cycle, and out of
+ * ProbeRTT once the window has stayed drained for PROBE_RTT_MS and a round trip.
+ */
+void BBR::update_mode(const AckSample &sample) {
+    const uint64_t inFlight = sample.prior_in_flight - sample.acked_bytes;
+
+    if (_mode == Mode::Startup and filledPipe) {
+        _mode = Mode::Drain;
+        pacingGain = 1 / HIGH_GAIN;
+        cwndGain = HIGH_GAIN;
+    }
+    if (_mode == Mode::Drain and inFlight <= target_cwnd(1)) {
+        enter_probe_bw(sample.now);
+    }
+
+    if (_mode == Mode::ProbeBW and minRtt) {
+        // each gain lasts a min RTT; the draining one ends early once the queue is gone
+        const bool fullLength = sample.now - cycleStart > *minRtt;
+        if (fullLength or (pacingGain < 1 and inFlight <= target_cwnd(1))) {
+            cycleIndex = (cycleIndex + 1) % PROBE_BW_GAINS.size();
+            cycleStart = sample.now;
+            pacingGain = PROBE_BW_GAINS[cycleIndex];
+        }
+    }
+
+    if (_mode == Mode::ProbeRTT) {
+        if (not probeRttDoneAt and inFlight <= MIN_CWND_SEGMENTS * _mss) {
+            probeRttDoneAt = sample.now + PROBE_RTT_MS;
+            probeRttRoundDone = false;
+            nextRoundDelivered = sample.delivered;
+        } else if (probeRttDoneAt) {
+            probeRttRoundDone = probeRttRoundDone or roundStart;
+            if (probeRttRoundDone and sample.now >= *probeRttDoneAt) {
+                minRttStamp = sample.now;
+                _cwnd = max(_cwnd, priorCwnd);
+                if (filledPipe) {
+                    enter_probe_bw(sample.now);
+                } else {
+                    _mode = Mode::Startup;
+                    pacingGain = cwndGain = HIGH_GAIN;
+                }
+            }
+        }
+    }
+}
+
+//! \details Until the pipe is full the window grows by every byte acknowledged; after that
+//! it grows towards the model's target but no further. ProbeRTT caps it at MIN_CWND_SEGMENTS.
+void BBR::update_cwnd(const AckSample &sample) {
+    const uint64_t target = target_cwnd(cwndGain);
+    if (filledPipe) {
+        _cwnd = min(_cwnd + sample.acked_bytes, target);
+    } else if (_cwnd < target) {
+        _cwnd += sample.acked_bytes;
+    }
+    _cwnd = max(_cwnd, uint64_t{MIN_CWND_SEGMENTS * _mss});
+    if (_mode == Mode::ProbeRTT) {
+        _cwnd = min(_cwnd, uint64_t{MIN_CWND_SEGMENTS * _mss});
+    }
+}
+
+//! \details Losses don't change the model: BBR reacts to the bandwidth and RTT it measures,
+//! not to drops, which on a shallow buffer don't mean the path is overloaded
+void BBR::on_loss(const uint64_t, const uint64_t) {}
+
+//! \details After a timeout nothing is known to be in flight, so the window starts over from
+//! one segment and grows back by the bytes acknowledged (the model is kept)
+void BBR::on_timeout(const uint64_t, const uint64_t) {
+    priorCwnd = max(priorCwnd, _cwnd);
+    _cwnd = _mss;
+}
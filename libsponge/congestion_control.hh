@@ -0,0 +1,218 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+//! \brief What the TCPSender learned from one acknowledgment that covered new data
+struct AckSample {
+    uint64_t now = 0;                         //!< sender's clock (ms since it was created)
+    uint64_t acked_bytes = 0;                 //!< sequence space newly acknowledged by this ACK
+    uint64_t prior_in_flight = 0;             //!< bytes in flight just before this ACK
+    std::optional<uint64_t> rtt{};            //!< round-trip time measured by this ACK, if any (ms)
+    bool in_recovery = false;                 //!< the sender is still repairing a loss (RFC 6582)
+    uint64_t delivered = 0;                   //!< bytes delivered over the whole connection, including this ACK
+    uint64_t prior_delivered = 0;             //!< `delivered` when the newest segment this ACK covers was sent
+    std::optional<uint64_t> delivery_rate{};  //!< bytes/s delivered while that segment was in flight
+    bool app_limited = false;                 //!< the sender ran out of data while that segment was in flight
+};
+
+//! \brief A congestion control algorithm, consulted by the TCPSender
+//!
+//! The sender keeps no more than cwnd() bytes in flight (on top of the receiver's window), and
+//! reports what happens to its segments through the on_*() methods. All sizes are in bytes.
+class CongestionControl {
+  public:
+    //! The algorithms TCPConfig can select
+    enum class Algorithm {
+        None,     //!< no congestion window: only the receiver's window limits the sender
+        NewReno,  //!< slow start and AIMD congestion avoidance (RFC 5681, RFC 6582)
+        Cubic,    //!< window growth as a cubic function of time since the last loss (RFC 9438)
+        BBR       //!< paces at the measured bottleneck bandwidth, with about one BDP in flight
+    };
+
+    //! Segments in the initial window (RFC 6928)
+    static constexpr size_t INITIAL_WINDOW = 10;
+
+    //! \brief Make the controller for `algorithm`, or nullptr for Algorithm::None
+    static std::unique_ptr<CongestionControl> make(const Algorithm algorithm, const size_t mss);
+
+    explicit CongestionControl(const size_t mss) : _mss(mss) {}
+    virtual ~CongestionControl() = default;
+
+    //! \brief New data was acknowledged
+    virtual void on_ack(const AckSample &sample) = 0;
+
+    //! \brief A loss was detected from SACK information (at most once per window of data)
+    virtual void on_loss(const uint64_t bytes_in_flight, const uint64_t now) = 0;
+
+    //! \brief The retransmission timer expired
+    virtual void on_timeout(const uint64_t bytes_in_flight, const uint64_t now) = 0;
+
+    //! \brief The most bytes the sender may have in flight
+    virtual uint64_t cwnd() const = 0;
+
+    //! \brief The rate (in bytes per second) to space segments out at, if the algorithm paces
+    virtual std::optional<uint64_t> pacing_rate() const { return {}; }
+
+    //! \brief The sender's segment size changed (e.g. to the peer's MSS option)
+    void set_mss(const size_t mss) { _mss = mss; }
+
+  protected:
+    size_t _mss;  //!< the sender's maximum segment size
+};
+
+//! \brief NewReno: exponential growth up to ssthresh, then one MSS per round trip, and
+//! halving on loss (RFC 5681)
+class NewReno : public CongestionControl {
+  private:
+    uint64_t _cwnd;
+    uint64_t ssthresh;
+
+    // bytes acknowledged since cwnd last grew during congestion avoidance
+    uint64_t ackedSinceGrowth;
+
+  public:
+    explicit NewReno(const size_t mss);
+
+    void on_ack(const AckSample &sample) override;
+    void on_loss(const uint64_t bytes_in_flight, const uint64_t now) override;
+    void on_timeout(const uint64_t bytes_in_flight, const uint64_t now) override;
+    uint64_t cwnd() const override { return _cwnd; }
+
+    //! \brief The slow start threshold
+    uint64_t slow_start_threshold() const { return ssthresh; }
+};
+
+//! \brief CUBIC (RFC 9438): after a loss, the window grows back along a cubic curve that
+//! is flat around the window where the loss happened, so it is independent of the RTT
+class Cubic : public CongestionControl {
+  public:
+    static constexpr double C = 0.4;     //!< scales the cubic curve (segments / s^3)
+    static constexpr double BETA = 0.7;  //!< window kept after a loss
+
+  private:
+    // windows in segments (as in RFC 9438), converted to bytes with the current MSS
+    double _cwnd;
+    double ssthresh;
+
+    // the window when the last loss happened, and the one just before it
+    double wMax;
+    double wLastMax;
+
+    // start of the current congestion avoidance epoch (ms), and the time (s) from it to
+    // reach wMax again
+    std::optional<uint64_t> epochStart;
+    double k;
+
+    // the window standard TCP would have reached in this epoch (RFC 9438 section 4.3)
+    double wEst;
+
+    // smallest RTT seen, in ms
+    std::optional<uint64_t> minRtt;
+
+    // records a loss: shrinks the window to BETA times its size and remembers wMax
+    void reduce();
+
+  public:
+    explicit Cubic(const size_t mss);
+
+    void on_ack(const AckSample &sample) override;
+    void on_loss(const uint64_t bytes_in_flight, const uint64_t now) override;
+    void on_timeout(const uint64_t bytes_in_flight, const uint64_t now) override;
+    uint64_t cwnd() const override { return static_cast<uint64_t>(_cwnd * _mss); }
+
+    //! \brief The slow start threshold
+    uint64_t slow_start_threshold() const { return static_cast<uint64_t>(ssthresh * _mss); }
+};
+
+//! \brief BBR (version 1): a model of the path, rather than loss, sets the sending rate
+//!
+//! It keeps the largest delivery rate seen over the last few round trips (the bottleneck
+//! bandwidth) and the smallest RTT seen over the last 10 s, paces segments at a gain times
+//! that bandwidth, and allows about two bandwidth-delay products in flight. The gain cycles
+//! slightly above and below 1 to probe for more bandwidth and drain any queue it built.
+class BBR : public CongestionControl {
+  public:
+    //! The phases of the algorithm
+    enum class Mode {
+        Startup,   //!< doubling the rate every round trip until the bandwidth stops growing
+        Drain,     //!< draining the queue Startup built
+        ProbeBW,   //!< cycling the pacing gain around 1
+        ProbeRTT,  //!< a few segments in flight for a moment, to measure the RTT without a queue
+    };
+
+    static constexpr double HIGH_GAIN = 2.885;            //!< 2/ln(2): doubles the rate each round trip
+    static constexpr size_t BW_WINDOW_ROUNDS = 10;        //!< round trips the bandwidth filter spans
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;  //!< how long a min RTT sample is kept
+    static constexpr uint64_t PROBE_RTT_MS = 200;         //!< how long ProbeRTT lasts
+    static constexpr size_t MIN_CWND_SEGMENTS = 4;        //!< smallest window, also used in ProbeRTT
+
+    //! ProbeBW's pacing gains, one per min RTT: probe for more bandwidth, drain what that queued, cruise
+    static constexpr std::array<double, 8> PROBE_BW_GAINS{1.25, 0.75, 1, 1, 1, 1, 1, 1};
+
+  private:
+    Mode _mode;
+    uint64_t _cwnd;
+    uint64_t pacingRate;  // bytes/s; 0 until there is an RTT sample
+    double pacingGain;
+    double cwndGain;
+
+    // round trips are counted by delivered bytes: one ends when a segment sent after it began is acked
+    uint64_t roundCount;
+    uint64_t nextRoundDelivered;
+    bool roundStart;
+
+    // the highest delivery rate (bytes/s) seen in each of the last BW_WINDOW_ROUNDS round trips
+    std::array<uint64_t, BW_WINDOW_ROUNDS> bwSamples;
+
+    // smallest RTT (ms) and when it was measured
+    std::optional<uint64_t> minRtt;
+    uint64_t minRttStamp;
+
+    // Startup ends once three round trips in a row have not grown the bandwidth by 25%
+    uint64_t fullBw;
+    unsigned int fullBwRounds;
+    bool filledPipe;
+
+    // ProbeBW: position in PROBE_BW_GAINS and when it was reached
+    size_t cycleIndex;
+    uint64_t cycleStart;
+
+    // ProbeRTT: when it may end (once the window has drained), whether a round trip has
+    // passed since, and the window to go back to
+    std::optional<uint64_t> probeRttDoneAt;
+    bool probeRttRoundDone;
+    uint64_t priorCwnd;
+
+    // the window the model calls for: `gain` bandwidth-delay products
+    uint64_t target_cwnd(const double gain) const;
+
+    void enter_probe_bw(const uint64_t now);
+    void update_model(const AckSample &sample);
+    void update_mode(const AckSample &sample);
+    void update_cwnd(const AckSample &sample);
+
+  public:
+    explicit BBR(const size_t mss);
+
+    void on_ack(const AckSample &sample) override;
+    void on_loss(const uint64_t bytes_in_flight, const uint64_t now) override;
+    void on_timeout(const uint64_t bytes_in_flight, const uint64_t now) override;
+    uint64_t cwnd() const override { return _cwnd; }
+    std::optional<uint64_t> pacing_rate() const override;
+
+    //! \brief The phase the algorithm is in
+    Mode mode() const { return _mode; }
+
+    //! \brief The estimated bottleneck bandwidth, in bytes/s
+    uint64_t bottleneck_bandwidth() const;
+
+    //! \brief The smallest recent RTT, in ms
+    std::optional<uint64_t> min_rtt() const { return minRtt; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
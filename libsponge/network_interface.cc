@@ -56,8 +56,8 @@ void NetworkInterface::send_ARP_message(uint32_t next_hop, uint16_t opcode) {
 
     // if the ARP message is a reply, set the target's ethernet address
     if (opcode == OPCODE_REPLY) {
-        arp.target_ethernet_address = IP_to_Ethernet[next_hop].first;
-        frame = create_frame(arp.serialize(), IP_to_Ethernet[next_hop].first, EthernetHeader::TYPE_ARP);
+        arp.target_ethernet_address = IP_to_Ethernet[next_hop];
+        frame = create_frame(arp.serialize(), IP_to_Ethernet[next_hop], EthernetHeader::TYPE_ARP);
     } else {
         frame = create_frame(arp.serialize(), ETHERNET_BROADCAST, EthernetHeader::TYPE_ARP);
     }
@@ -75,7 +75,7 @@ void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Addres
     auto it1 = IP_to_Ethernet.find(next_hop_ip);
     if (it1 != IP_to_Ethernet.end()) {
         EthernetFrame frame =
-            create_frame(dgram.serialize(), IP_to_Ethernet[next_hop_ip].first, EthernetHeader::TYPE_IPv4);
+            create_frame(dgram.serialize(), IP_to_Ethernet[next_hop_ip], EthernetHeader::TYPE_IPv4);
         _frames_out.push(frame);
     }
 
@@ -83,13 +83,13 @@ void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Addres
     else {
         queue<InternetDatagram> empty;
         // if no ARP request asking about next_hop has been sent in the past 5 seconds
-        // reset the number of seconds since ARP request sent to 0 and send ARP request
+        // record the time and send ARP request
         auto it2 = dgrams_to_send.find(next_hop_ip);
         if (it2 == dgrams_to_send.end()) {
-            dgrams_to_send[next_hop_ip] = pair<queue<InternetDatagram>, size_t>(empty, 0);
+            dgrams_to_send[next_hop_ip] = pair<queue<InternetDatagram>, uint64_t>(empty, now);
             send_ARP_message(next_hop_ip, OPCODE_REQUEST);
-        } else if (dgrams_to_send[next_hop_ip].second >= ARP_REQUEST_TIMEOUT) {
-            dgrams_to_send[next_hop_ip].second = 0;
+        } else if (now - dgrams_to_send[next_hop_ip].second >= ARP_REQUEST_TIMEOUT) {
+            dgrams_to_send[next_hop_ip].second = now;
             send_ARP_message(next_hop_ip, OPCODE_REQUEST);
         }
         // add dgram to list of d_grams_to_send to IP Address next_hop
@@ -108,7 +108,7 @@ void NetworkInterface::send_queued_datagrams(uint32_t addr) {
     queue<InternetDatagram> to_send = dgrams_to_send[addr].first;
 
     // ethernet address associated with IP address addr
-    EthernetAddress eth = IP_to_Ethernet[addr].first;
+    EthernetAddress eth = IP_to_Ethernet[addr];
 
     // send all dgrams in queue waiting to go to eth
     while (!to_send.empty()) {
@@ -146,7 +146,8 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
             return {};
         }
         // map sender IP address to sender Ethernet address with TTL 30 seconds
-        IP_to_Ethernet[arp.sender_ip_address] = pair<EthernetAddress, size_t>(arp.sender_ethernet_address, CACHE_TTL);
+        IP_to_Ethernet[arp.sender_ip_address] = arp.sender_ethernet_address;
+        cache_expiry.schedule(arp.sender_ip_address, now + CACHE_TTL);
 
         // send any datagrams that were waiting to learn the ethernet address
         send_queued_datagrams(arp.sender_ip_address);
@@ -161,28 +162,21 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick(const size_t ms_since_last_tick) {
-    // stores IP addresses to remove from the map
-    queue<uint32_t> to_remove;
-
-    // if IP Address to Ethernet address has been cached longer than 30 seconds, remove it
-    // otherwise decrement TTL
-    for (auto it = IP_to_Ethernet.begin(); it != IP_to_Ethernet.end(); it++) {
-        if (it->second.second <= ms_since_last_tick) {
-            to_remove.push(it->first);
-        } else {
-            it->second.second -= ms_since_last_tick;
-        }
-    }
+    now += ms_since_last_tick;
 
-    while (!to_remove.empty()) {
-        IP_to_Ethernet.erase(to_remove.front());
-        to_remove.pop();
+    // if IP Address to Ethernet address has been cached for 30 seconds, remove it
+    // (ARP requests need no timer: send_datagram() compares the time the last one was sent)
+    cache_expiry.advance(now, expired);
+    for (const TimerWheel::Key addr : expired) {
+        IP_to_Ethernet.erase(addr);
     }
+    expired.clear();
+}
 
-    // keep track of ms since ARP request sent for each IP address
-    for (auto it = dgrams_to_send.begin(); it != dgrams_to_send.end(); it++) {
-        if (it->second.second < ARP_REQUEST_TIMEOUT) {
-            it->second.second += ms_since_last_tick;
-        }
+optional<size_t> NetworkInterface::time_until_deadline() const {
+    const optional<uint64_t> deadline = cache_expiry.next_deadline();
+    if (!deadline) {
+        return {};
     }
+    return *deadline > now ? *deadline - now : 0;
 }
@@ -11,12 +11,14 @@
 #include "ethernet_frame.hh"
 #include "ethernet_header.hh"
 #include "tcp_over_ip.hh"
+#include "timer_wheel.hh"
 #include "tun.hh"
 
 #include <map>
 #include <optional>
 #include <queue>
 #include <utility>
+#include <vector>
 
 //! \brief A "network interface" that connects IP (the internet layer, or network layer)
 //! with Ethernet (the network access layer, or link layer).
@@ -50,11 +52,19 @@ class NetworkInterface {
     //! outbound queue of Ethernet frames that the NetworkInterface wants sent
     std::queue<EthernetFrame> _frames_out{};
 
-    // map from IP addresses to queue of datagrams and amount of time since ARP request asking about that IP address
-    std::map<uint32_t, std::pair<std::queue<InternetDatagram>, size_t>> dgrams_to_send{};
+    // milliseconds since the interface was created (the sum of all ticks)
+    uint64_t now{0};
 
-    // map from IP addresses to Ethernet addresses and amount of time the value has been cached
-    std::map<uint32_t, std::pair<EthernetAddress, size_t>> IP_to_Ethernet{};
+    // map from IP addresses to queue of datagrams and the time the last ARP request asking about that IP address was sent
+    std::map<uint32_t, std::pair<std::queue<InternetDatagram>, uint64_t>> dgrams_to_send{};
+
+    // map from IP addresses to Ethernet addresses
+    std::map<uint32_t, EthernetAddress> IP_to_Ethernet{};
+
+    // when each cached Ethernet address expires, keyed by IP address, so tick() only touches the
+    // entries that expire instead of every entry in the cache
+    TimerWheel cache_expiry{};
+    std::vector<TimerWheel::Key> expired{};
 
     // creates an EthernetFrame
     EthernetFrame create_frame(BufferList payload, EthernetAddress addr, uint16_t type);
@@ -97,6 +107,9 @@ class NetworkInterface {
 
     //! \brief Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Milliseconds until tick() next has something to do (a cached address expires), or empty if never
+    std::optional<size_t> time_until_deadline() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
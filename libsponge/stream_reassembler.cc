@@ -1,269 +1,355 @@
 /*
  * Filename: stream_reassembler.cc
  * Author: Maggie Gray
- * Description: This file implements a StreamReassembler which reassembles Unassembled strings to
- * send to a ByteStream.
+ * Description: This file implements a StreamReassembler which reassembles out-of-order
+ * chunks of data to send to a ByteStream. Unassembled chunks are kept in an ordered map
+ * keyed by their start index, so finding the chunks a new substring overlaps takes
+ * logarithmic time in the number of holes. Chunks are slices of the Buffers they
+ * arrived in, so out-of-order payloads are not copied. Alternatively (the Bitmap backend) they are
+ * copied into a preallocated ring with a bitmap recording which slots are filled.
  */
 
 #include "stream_reassembler.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
 using namespace std;
 
 /*
- * Function: checkOverlaps
- * Args: Unassembled u1, Unassembled u2
- * Description: This function takes in Unassembled structs and checks to see if their data overlaps.
- * If they overlap, it returns true. Otherwise, it returns false.
+ * Function: insert_chunk
+ * Args: Buffer data, size_t start
+ * Description: This function takes in a slice of data that covers [start, end) and fits
+ * in the reassembler's window. It trims off the front of data if the chunk before it
+ * already covers those bytes, drops any chunks that data covers completely, and trims
+ * the front of a chunk that sticks out past end. Trimming is done with remove_prefix,
+ * so no bytes are copied, and finding the neighbours takes logarithmic time. Data that
+ * starts at currentIndex is written straight to the ByteStream instead of being stored.
  */
-bool StreamReassembler::checkOverlaps(Unassembled u1, Unassembled u2) {
-    // u1 starts in the middle of u2
-    if (u1.startIndex >= u2.startIndex && u1.startIndex <= u2.endIndex) {
-        return true;
-    }
-
-    // u2 starts in the middle of u1
-    if (u2.startIndex >= u1.startIndex && u2.startIndex <= u1.endIndex) {
-        return true;
+void StreamReassembler::insert_chunk(Buffer data, size_t start) {
+    const size_t end = start + data.size();
+
+    // skip whatever the chunk before start already covers
+    auto it = unassembled.upper_bound(start);
+    if (it != unassembled.begin()) {
+        const auto prev = std::prev(it);
+        const size_t prevEnd = prev->first + prev->second.size();
+        if (prevEnd >= end) {
+            return;
+        }
+        if (prevEnd > start) {
+            data.remove_prefix(prevEnd - start);
+            start = prevEnd;
+        }
     }
 
-    return false;
-}
+    // remove the chunks that data covers, and trim the one that runs past its end
+    while (it != unassembled.end() && it->first < end) {
+        const size_t chunkEnd = it->first + it->second.size();
+        if (chunkEnd <= end) {
+            bytesInList -= it->second.size();
+            it = unassembled.erase(it);
+            continue;
+        }
 
-/*
- * Function: constructOverlapping
- * Args: Unassembled u1, Unassembled u2
- * Description: This function takes in two overlapping Unassembled structs and merges their data into
- * one Unassembled. It returns the merged Unassembed.
- */
-Unassembled StreamReassembler::constructOverlapping(Unassembled u1, Unassembled u2) {
-    Unassembled overlapping;
-    string data = "";
-
-    // set overlapping's start index to be the smaller start index of u1 and u2
-    // copy in the beginning of the string
-    int nextIndexNeeded = 0;
-    if (u1.startIndex < u2.startIndex) {
-        overlapping.startIndex = u1.startIndex;
-        data += u1.str;
-        nextIndexNeeded += u1.startIndex + u1.str.length();
-    } else {
-        overlapping.startIndex = u2.startIndex;
-        data += u2.str;
-        nextIndexNeeded += u2.startIndex + u2.str.length();
+        // re-key the node in place rather than allocating a new one
+        auto node = unassembled.extract(it);
+        bytesInList -= end - node.key();
+        node.mapped().remove_prefix(end - node.key());
+        node.key() = end;
+        unassembled.insert(move(node));
+        break;
     }
 
-    // set overlapping's end index to be the larger end index of u1 and u2
-    // copy in the rest of the string if there is more to copy
-    if (u1.endIndex > u2.endIndex) {
-        overlapping.endIndex = u1.endIndex;
-        if (overlapping.endIndex >= data.length()) {
-            data += u1.str.substr(nextIndexNeeded - u1.startIndex);
-        }
+    if (start == currentIndex) {
+        // in-order bytes go directly to the ByteStream
+        _output.write(move(data));
+        currentIndex = end;
     } else {
-        overlapping.endIndex = u2.endIndex;
-        if (overlapping.endIndex >= data.length()) {
-            data += u2.str.substr(nextIndexNeeded - u2.startIndex);
-        }
+        bytesInList += data.size();
+        unassembled.emplace(start, move(data));
     }
-
-    overlapping.str = data;
-    return overlapping;
 }
 
 /*
- * Function: addToList
- * Arg: Unassembled current
- * Description: This function takes in an Unassembled and adds it to our list of Unassembleds.
- * It combines the Unassembled with any elements of the list that it overlaps with and then adds it
- * to the list in a sorted order based on its first index.
+ * Function: flush_contiguous
+ * Description: This function writes the chunks at the front of the map to the ByteStream
+ * for as long as they start exactly at currentIndex, and removes them from the map.
  */
-void StreamReassembler::addToList(Unassembled current) {
-    // do not add it to the list if it is the empty string
-    // if (current.str == "") return;
-
-    // if the list is empty, add current to the front of the list and return
-    if (unassembledList.empty()) {
-        unassembledList.push_front(current);
-        bytesInList += current.str.length();
-        return;
+void StreamReassembler::flush_contiguous() {
+    while (!unassembled.empty() && unassembled.begin()->first == currentIndex) {
+        auto front = unassembled.begin();
+        currentIndex += front->second.size();
+        bytesInList -= front->second.size();
+        _output.write(move(front->second));
+        unassembled.erase(front);
     }
+}
 
-    // if the list is not empty, check if current data overlaps with existing data
-    // insert into list sorted by index
-    for (auto it = unassembledList.begin(); it != unassembledList.end(); it++) {
-        Unassembled next = *it;
-        if (checkOverlaps(current, next)) {
-            Unassembled overlapping = constructOverlapping(current, next);
-
-            // remove the unassembled data we overlap with
-            auto nextIt = unassembledList.erase(it);
-            bytesInList -= next.str.length();
-
-            // While we are not at the end of our list, check to see if the next element
-            // overlaps. If it does, combine the next element with overlapping and look
-            // at the next element after it. If they do not overlap, break the while loop
-            while (nextIt != unassembledList.end()) {
-                Unassembled nextItUnass = *nextIt;
-                if (checkOverlaps(overlapping, nextItUnass)) {
-                    overlapping = constructOverlapping(overlapping, nextItUnass);
-                    bytesInList -= nextItUnass.str.length();
-                    nextIt = unassembledList.erase(nextIt);
-                } else {
-                    break;
-                }
-            }
-
-            // insert new overlapping string into our list and return
-            unassembledList.insert(nextIt, overlapping);
-            bytesInList += overlapping.str.length();
-            return;
+/*
+ * Function: mark_slots
+ * Args: size_t slot, size_t len, const bool set
+ * Description: This function sets (or clears) the occupancy bits of len ring slots
+ * starting at slot, wrapping around the end of the ring. It works a 64-bit word at a
+ * time and uses popcount to return how many bits actually changed, so a byte that
+ * was already buffered is never counted twice.
+ */
+size_t StreamReassembler::mark_slots(size_t slot, size_t len, const bool set) {
+    size_t changed = 0;
+    while (len > 0) {
+        const size_t word = slot / 64;
+        const size_t offset = slot % 64;
+        const size_t n = min({len, 64 - offset, _capacity - slot});
+        const uint64_t mask = (n == 64 ? ~uint64_t{0} : ((uint64_t{1} << n) - 1)) << offset;
+
+        if (set) {
+            changed += __builtin_popcountll(mask & ~occupied[word]);
+            occupied[word] |= mask;
+        } else {
+            changed += __builtin_popcountll(mask & occupied[word]);
+            occupied[word] &= ~mask;
         }
 
-        // if our current unassembled chunk does not overlap with the next chunk and
-        // its start index is smaller than the start index of the next chunk, then
-        // insert it into the list and return
-        if (current.startIndex < next.startIndex) {
-            unassembledList.insert(it, current);
-            bytesInList += current.str.length();
-            return;
-        }
+        len -= n;
+        slot = (slot + n) % _capacity;
     }
-    // put it at the back otherwise
-    unassembledList.push_back(current);
-    bytesInList += current.str.length();
+    return changed;
 }
 
 /*
- * Function: protected_write
- * Args: Unassembled current
- * Description: This function takes in an Unassembled and writes its data to the ByteStream _output.
- * It also checks to see if the file is EOF and increments the currentIndex variable.
+ * Function: slot_run
+ * Args: const size_t slot, const size_t maxLen, const bool filled
+ * Description: This function counts how many consecutive ring slots starting at slot
+ * are filled (or empty, if filled is false), stopping at the first slot that is not,
+ * or after maxLen slots.
  */
-void StreamReassembler::protected_write(Unassembled current) {
-    // write the string to the bytestream and increment our current index
-    _output.write(current.str);
-    currentIndex += current.str.length();
-
-    // if we have hit the index where we hit EOF and EOF has been pushed, end the output
-    if (currentIndex == eofIndex && eofPushed) {
-        _output.end_input();
+size_t StreamReassembler::slot_run(const size_t slot, const size_t maxLen, const bool filled) const {
+    size_t run = 0;
+    while (run < maxLen) {
+        const size_t pos = (slot + run) % _capacity;
+        const size_t offset = pos % 64;
+        const size_t limit = min({64 - offset, _capacity - pos, maxLen - run});
+
+        // trailing zeros of the word (inverted, when counting filled slots) are the run
+        const uint64_t other = (filled ? ~occupied[pos / 64] : occupied[pos / 64]) >> offset;
+        const size_t n = (other == 0) ? limit : min(limit, static_cast<size_t>(__builtin_ctzll(other)));
+
+        run += n;
+        if (n < limit) {
+            break;
+        }
     }
+    return run;
 }
 
 /*
- * Function: write_substring
- * Args: Unassembled current
- * Description: This function takes in an Unassembled
+ * Function: store_in_ring
+ * Args: const Buffer &data, const size_t start
+ * Description: This function takes in a slice of data that covers [start, end) and fits
+ * in the reassembler's window. If it starts at currentIndex it is written straight to
+ * the ByteStream; otherwise it is memcpy'd into its ring slots (in at most two pieces)
+ * and the slots are marked as filled.
  */
-void StreamReassembler::write_substring(Unassembled current) {
-    // check to see if our new unassembled chunk overlaps with the next chunk to
-    // be written to the byte stream
-    // if they overlap, write the combined chunk to the byte stream, otherwise write
-    // the new data to the bytestream
-    while (!unassembledList.empty() && checkOverlaps(current, unassembledList.front())) {
-        Unassembled overlapping = constructOverlapping(current, unassembledList.front());
-        bytesInList -= unassembledList.front().str.length();
-        unassembledList.pop_front();
-        current = overlapping;
-    }
+void StreamReassembler::store_in_ring(const Buffer &data, const size_t start) {
+    const size_t slot = start % _capacity;
+    const size_t len = data.size();
 
-    protected_write(current);
+    if (start == currentIndex) {
+        _output.write(data);
+        currentIndex = start + len;
 
-    // check to see if the front of our list can be written
-    // if it can be written, then write it and remove it from unassembledList
-    while (!unassembledList.empty() && (currentIndex == unassembledList.front().startIndex)) {
-        protected_write(unassembledList.front());
-        bytesInList -= unassembledList.front().str.length();
-        unassembledList.pop_front();
+        // any of these bytes that were already buffered out of order are no longer needed
+        bytesInList -= mark_slots(slot, len, false);
+        return;
     }
+
+    const size_t firstPiece = min(len, _capacity - slot);
+    memcpy(ring.data() + slot, data.str().data(), firstPiece);
+    memcpy(ring.data(), data.str().data() + firstPiece, len - firstPiece);
+    bytesInList += mark_slots(slot, len, true);
 }
 
 /*
- * Function: createUnassembled
- * Args: const string &data, const size_t index
- * Description: This function takes in a string and an index and constructs an Unassembled
- * containing that string and start index. It returns an Unassembled.
+ * Function: flush_ring
+ * Description: This function finds the run of filled slots starting at currentIndex
+ * and copies it into the ByteStream's free space in one bulk write.
  */
-Unassembled StreamReassembler::createUnassembled(const string &data, const size_t index) {
-    // create a new Unassembled chunk of data
-    struct Unassembled current;
-    current.startIndex = index;
-    current.endIndex = index + data.length() - 1;
-
-    // if we do not have capacity for the end of the string, discard it
-    if (current.endIndex > maxEndIndex) {
-        string str = data.substr(0, maxEndIndex + 1 - index);
-        current.str.assign(str);
-    } else {
-        current.str.assign(data);
+void StreamReassembler::flush_ring() {
+    const size_t slot = currentIndex % _capacity;
+    const size_t run = slot_run(slot, _output.remaining_capacity());
+    if (run == 0) {
+        return;
     }
-    return current;
+
+    // copy from the ring (which may wrap) into the stream's regions (which may also wrap)
+    size_t copied = 0;
+    for (const auto &region : _output.reserve_write(run)) {
+        char *dest = static_cast<char *>(region.iov_base);
+        size_t remaining = region.iov_len;
+        while (remaining > 0) {
+            const size_t from = (slot + copied) % _capacity;
+            const size_t n = min(remaining, _capacity - from);
+            memcpy(dest, ring.data() + from, n);
+            dest += n;
+            remaining -= n;
+            copied += n;
+        }
+    }
+    _output.commit_write(run);
+
+    bytesInList -= mark_slots(slot, run, false);
+    currentIndex += run;
 }
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    // find the maximum end index a string can have, based on the reassembler's capacity
-    maxEndIndex = _capacity + _output.bytes_read() - 1;
+    // the common case, in-order data that fits with nothing held out of order, goes straight
+    // from the string to the ByteStream; only data that may have to be stored becomes a Buffer
+    const size_t dataEnd = index + data.size();
+    if (index != currentIndex || bytesInList != 0 || dataEnd > _output.bytes_read() + _capacity) {
+        push_substring(Buffer(string(data)), index, eof);
+        return;
+    }
 
-    // if data chunk has EOF set, set our global eofPushed variable to true
-    // and record the index where we hit EOF
+    _output.write(data);
+    currentIndex = dataEnd;
     if (eof) {
         eofPushed = true;
-        eofIndex = index + data.length();
+        eofIndex = dataEnd;
     }
-
-    // if we have hit the index where we hit EOF, end the output and return
-    if (currentIndex == eofIndex && eofPushed) {
+    if (eofPushed && currentIndex == eofIndex) {
         _output.end_input();
-        return;
     }
+}
 
-    // if the string is empty, discard it
-    if (data == "") {
-        return;
-    }
+//! \details Same as above, but out-of-order bytes are stored as slices of `data`.
+void StreamReassembler::push_substring(Buffer data, const size_t index, const bool eof) {
+    const size_t dataEnd = index + data.size();
 
-    // if we do not have capacity for the string, discard it
-    if (index > maxEndIndex) {
-        return;
+    // if data chunk has EOF set, set our global eofPushed variable to true
+    // and record the index where we hit EOF
+    if (eof) {
+        eofPushed = true;
+        eofIndex = dataEnd;
     }
 
-    // create a new Unassembled struct
-    struct Unassembled current = createUnassembled(data, index);
+    // only the part of the data between the next index needed and the end of
+    // our capacity can be stored; anything before it has already been written
+    // and anything after it is silently discarded
+    const size_t windowEnd = _output.bytes_read() + _capacity;
+    const size_t start = max(index, currentIndex);
+    const size_t end = min(dataEnd, windowEnd);
 
-    // if the index of the data is the next index, then write it to the byte stream
+    if (start < end) {
+        data.remove_prefix(start - index);
 
-    if (index == currentIndex) {
-        write_substring(current);
-        return;
+        // drop bytes past the window (this only happens if the sender overruns it)
+        if (end < dataEnd) {
+            data = data.slice(0, end - start);
+        }
+
+        if (backend == Backend::Bitmap) {
+            store_in_ring(data, start);
+            flush_ring();
+        } else {
+            insert_chunk(move(data), start);
+            flush_contiguous();
+        }
     }
 
-    // if part (but not all) of the data chunk has already been written
-    else if (current.startIndex < currentIndex && current.endIndex >= currentIndex) {
-        // get the part of the string that has not yet been written
-        string toWrite = current.str.substr(currentIndex - current.startIndex);
-        current.str = toWrite;
+    // if we have hit the index where we hit EOF, end the output
+    if (eofPushed && currentIndex == eofIndex) {
+        _output.end_input();
+    }
+}
 
-        // set proper start index and write the Unassembled chunk of data
-        current.startIndex = currentIndex;
-        write_substring(current);
-        return;
+/*
+ * Function: set_capacity
+ * Args: const size_t capacity
+ * Return: size_t, the capacity now in effect
+ * Description: This function grows or shrinks the window of bytes the reassembler will
+ * store, and the ByteStream with it, but never so far that bytes already stored fall out
+ * of it. The interval map is keyed by stream index, so only the limit changes; the
+ * Bitmap backend's slots depend on the capacity, so the unassembled ranges are copied
+ * out of the old ring and stored again in a new one.
+ */
+size_t StreamReassembler::set_capacity(const size_t capacity) {
+    const auto ranges = unassembled_ranges(SIZE_MAX);
+    const size_t needed = ranges.empty() ? _output.buffer_size() : ranges.back().second - _output.bytes_read();
+    const size_t newCapacity = max(capacity, needed);
+    if (newCapacity == _capacity) {
+        return _capacity;
     }
 
-    // if we have already written all the data in this chunk, return
-    else if (current.startIndex < currentIndex && current.endIndex < currentIndex) {
-        return;
+    // the Bitmap backend's unassembled bytes have to be copied out before their slots move
+    vector<pair<size_t, string>> saved;
+    if (backend == Backend::Bitmap) {
+        for (const auto &[start, end] : ranges) {
+            string bytes(end - start, '\0');
+            const size_t slot = start % _capacity;
+            const size_t firstPiece = min(bytes.size(), _capacity - slot);
+            memcpy(bytes.data(), ring.data() + slot, firstPiece);
+            memcpy(bytes.data() + firstPiece, ring.data(), bytes.size() - firstPiece);
+            saved.emplace_back(start, move(bytes));
+        }
     }
 
-    // if we are not ready to write this data to the bytestream, and we have capacity
-    // add it to our list of unassembled data
-    else if (_capacity >= data.length()) {
-        addToList(current);
+    _capacity = newCapacity;
+    if (backend == Backend::Bitmap) {
+        ring.assign(newCapacity, '\0');
+        occupied.assign((newCapacity + 63) / 64, 0);
+        bytesInList = 0;
+        for (auto &[start, bytes] : saved) {
+            store_in_ring(Buffer(move(bytes)), start);
+        }
     }
+
+    _output.set_capacity(newCapacity);
+    return _capacity;
 }
 
 size_t StreamReassembler::unassembled_bytes() const { return bytesInList; }
 
+//! \details The interval map backend walks the map from its first chunk, merging chunks
+//! that touch; the Bitmap backend skips empty and filled runs of the ring a word at a time.
+//! Either way the cost grows with the number of ranges returned, not the bytes they hold.
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges(const size_t max_ranges) const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    if (bytesInList == 0 or max_ranges == 0) {
+        return ranges;
+    }
+
+    if (backend == Backend::Bitmap) {
+        // buffered bytes can only live between currentIndex and the end of the window
+        const size_t windowEnd = _output.bytes_read() + _capacity;
+        size_t index = currentIndex;
+        while (index < windowEnd and ranges.size() < max_ranges) {
+            index += slot_run(index % _capacity, windowEnd - index, false);
+            const size_t run = slot_run(index % _capacity, windowEnd - index);
+            if (run == 0) {
+                break;
+            }
+            ranges.emplace_back(index, index + run);
+            index += run;
+        }
+        return ranges;
+    }
+
+    for (const auto &[start, chunk] : unassembled) {
+        if (!ranges.empty() and ranges.back().second == start) {
+            ranges.back().second += chunk.size();
+            continue;
+        }
+        if (ranges.size() == max_ranges) {
+            break;
+        }
+        ranges.emplace_back(start, start + chunk.size());
+    }
+    return ranges;
+}
+
 // true if there are no unassembled bytes, false otherwise
 bool StreamReassembler::empty() const { return (unassembled_bytes() == 0); }
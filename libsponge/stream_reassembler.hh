@@ -10,61 +10,71 @@
 
 #include "byte_stream.hh"
 
-#include <algorithm>
 #include <cstdint>
-#include <iostream>
-#include <iterator>
-#include <list>
+#include <map>
 #include <string>
-
-using namespace std;
-
-// This struct represents unassembled chunks of data. It includes the string of the data
-// and the string's start and end index
-struct Unassembled {
-  public:
-    size_t startIndex;
-    size_t endIndex;
-    string str;
-    Unassembled() : startIndex{0}, endIndex{0}, str{""} {};
-};
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! Where out-of-order bytes are kept until they can be reassembled
+    enum class Backend {
+        IntervalMap,  //!< An ordered map of non-overlapping chunks, allocated as segments arrive
+        Bitmap        //!< One preallocated ring of `capacity` bytes plus a bitmap of the filled slots
+    };
+
   private:
     ByteStream _output;   //!< The reassembled in-order byte stream
     size_t _capacity;     //!< The maximum number of bytes
     size_t currentIndex;  //!< The next index the Reassembler needs to write to the ByteStream
 
-    // a list of unassembled chunks of data
-    list<Unassembled> unassembledList;
+    // unassembled chunks of data keyed by the index of their first byte. Chunks never
+    // overlap, so each buffered byte is stored (and counted) exactly once. Each chunk is
+    // a slice of the Buffer it arrived in, so its bytes are shared rather than copied.
+    std::map<size_t, Buffer> unassembled;
+
+    // stores data, which covers [start, start + data.size()), replacing any chunks it
+    // covers and trimming the front of one it partly overlaps; writes it straight to
+    // the ByteStream instead if it starts at currentIndex
+    void insert_chunk(Buffer data, size_t start);
+
+    // writes every chunk that has become contiguous with currentIndex to the ByteStream
+    void flush_contiguous();
 
-    // adds an Unassembled to the list of Unassembled chunks of data
-    void addToList(Unassembled current);
+    // which of the two structures below holds the unassembled data
+    Backend backend;
 
-    // checks to see if two Unassembled chunks of data overlap
-    bool checkOverlaps(Unassembled u1, Unassembled u2);
+    // Bitmap backend: ring of _capacity bytes where the byte with stream index i lives
+    // in slot i % _capacity. The window never spans more than _capacity indexes, so
+    // live slots cannot collide.
+    std::string ring;
 
-    // constructs a new Unassembled chunk by merging the data of two
-    // overlapping Unassembled chunks
-    Unassembled constructOverlapping(Unassembled u1, Unassembled u2);
+    // Bitmap backend: one bit per ring slot, set if the slot holds an unassembled byte
+    std::vector<uint64_t> occupied;
 
-    // writes a string to the ByteStream
-    void write_substring(Unassembled current);
-    void protected_write(Unassembled current);
+    // Bitmap backend: copies data, which covers [start, start + data.size()), into its
+    // ring slots, or straight to the ByteStream if it starts at currentIndex
+    void store_in_ring(const Buffer &data, const size_t start);
 
-    // creates an Unassembled struct that stores the string data and its
-    // start and end index
-    Unassembled createUnassembled(const string &data, const size_t index);
+    // Bitmap backend: writes the filled run of slots starting at currentIndex to the
+    // ByteStream in one bulk write
+    void flush_ring();
+
+    // Bitmap backend: sets or clears the bits for len slots starting at slot (wrapping
+    // around the ring), and returns how many bits actually changed
+    size_t mark_slots(size_t slot, size_t len, const bool set);
+
+    // Bitmap backend: the number of consecutive slots starting at slot that are filled
+    // (or, if filled is false, empty), up to maxLen
+    size_t slot_run(const size_t slot, const size_t maxLen, const bool filled = true) const;
 
     // stores the number of bytes of data currently unassembled and stored in
-    // the Unassembled list
+    // the unassembled map or ring
     size_t bytesInList;
 
-    // records the maximum end index our list of Unassembleds can store
-    size_t maxEndIndex;
-
     // records whether EOF has been pushed
     bool eofPushed;
 
@@ -75,13 +85,22 @@ class StreamReassembler {
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity)
-        : _output(capacity)
+    //! \note The Bitmap backend allocates all of its memory here (a ring of `capacity`
+    //! bytes plus `capacity` / 8 bytes of bitmap), so its footprint does not depend on
+    //! how segments arrive.
+    //! \note With `storage` Chunked, in-order Buffers pushed in are handed to the output
+    //! stream by reference, so their bytes are never copied on the way to the reader.
+    StreamReassembler(const size_t capacity,
+                      const Backend backend_type = Backend::IntervalMap,
+                      const ByteStream::Storage storage = ByteStream::Storage::Contiguous)
+        : _output(capacity, storage)
         , _capacity(capacity)
         , currentIndex(0)
-        , unassembledList()
+        , unassembled()
+        , backend(backend_type)
+        , ring(backend_type == Backend::Bitmap ? capacity : 0, '\0')
+        , occupied(backend_type == Backend::Bitmap ? (capacity + 63) / 64 : 0, 0)
         , bytesInList(0)
-        , maxEndIndex(0)
         , eofPushed(0)
         , eofIndex(0){};
 
@@ -95,6 +114,12 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer (e.g. a TCP segment's payload).
+    //!
+    //! Out-of-order bytes are kept as slices of `data` instead of being copied, so they
+    //! share memory with the parsed segment. Otherwise the same as the std::string overload.
+    void push_substring(Buffer data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -107,6 +132,24 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The ranges of bytes that have been received but not yet reassembled.
+    //!
+    //! Each range is a half-open interval [first, second) of absolute stream indexes.
+    //! Ranges are returned in increasing order, never touch or overlap, and never include
+    //! bytes that have already been reassembled. Only indexes are reported; no data is copied.
+    //! \param max_ranges at most this many ranges (the lowest ones) are returned
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges(const size_t max_ranges) const;
+
+    //! \brief Change the capacity (of the output stream too), though never to less than is already
+    //! stored: the bytes waiting to be read, and everything up to the last unassembled byte
+    //! \returns the capacity now in effect
+    //! \note The Bitmap backend reallocates its ring and bitmap, and copies the unassembled bytes
+    //! into their new slots.
+    size_t set_capacity(const size_t capacity);
+
+    //! \brief The maximum number of bytes, reassembled or not, that can be stored
+    size_t capacity() const { return _capacity; }
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
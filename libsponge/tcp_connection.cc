@@ -33,9 +33,6 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     if (_sender.next_seqno_absolute() == 0 && !seg.header().syn)
         return;
 
-    // reset time_since_segment_received
-    time_since_segment_received = 0;
-
     // if RST flag is set, set errors on both byte streams
     if (seg.header().rst) {
         _receiver.stream_out().set_error();
@@ -43,8 +40,63 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         reset = true;
     }
 
-    // sends segment to receiver
-    _receiver.segment_received(seg);
+    // SACK is used only if both SYNs offered it
+    if (seg.header().syn && seg.header().options.sack_permitted && _cfg.sack) {
+        sackEnabled = true;
+    }
+
+    // never send segments larger than the peer's MSS
+    if (seg.header().syn && seg.header().options.mss) {
+        segmentSize = min(_cfg.mss, static_cast<size_t>(*seg.header().options.mss));
+    }
+
+    // window scaling is used only if both SYNs offered it
+    if (seg.header().syn && seg.header().options.window_scale && _cfg.window_scaling) {
+        windowScalingEnabled = true;
+        sendShift = min(*seg.header().options.window_scale, TCPConfig::MAX_WINDOW_SHIFT);
+        recvShift = TCPConfig::window_shift(_cfg.recv_capacity_limit());
+    }
+
+    // timestamps are used only if both SYNs offered them
+    if (seg.header().syn && seg.header().options.timestamps && _cfg.timestamps) {
+        timestampsEnabled = true;
+        _receiver.use_timestamps();
+    }
+
+    // the MSS covers the options on every segment as well as the payload (RFC 6691), so leave
+    // room for timestamps once they are in use
+    if (seg.header().syn) {
+        _sender.set_max_payload_size(segmentSize - (timestampsEnabled ? TCPOptions::TIMESTAMPS_SPACE : 0));
+    }
+
+    // sends segment to receiver; one PAWS drops as an old duplicate carries a stale ackno,
+    // window, and SACK blocks too, so it is only acknowledged right away (RFC 7323 section 5.3)
+    const optional<WrappingInt32> expected = _receiver.ackno();
+    if (!_receiver.segment_received(seg)) {
+        _sender.send_empty_segment();
+        send_segments();
+        return;
+    }
+
+    // reset time_since_segment_received
+    time_since_segment_received = 0;
+
+    // with delayed ACKs, in-order data can wait for a segment of ours to carry its ACK, unless
+    // two full segments' worth is now unacknowledged; a SYN, a FIN, or anything out of order
+    // (including data that fills a hole) is acknowledged right away. Before the peer's SYN there
+    // is no ackno, so nothing waits to be acknowledged
+    bool ackNow = true;
+    if (seg.length_in_sequence_space() > 0 && _receiver.ackno().has_value()) {
+        if (!ackPending) {
+            ackPending = true;
+            ackDelay = 0;
+        }
+        unackedBytes += seg.payload().size();
+        const bool inOrder = expected == seg.header().seqno &&
+                             _receiver.ackno() == seg.header().seqno + seg.length_in_sequence_space() &&
+                             _receiver.unassembled_bytes() == 0;
+        ackNow = !inOrder || seg.header().syn || seg.header().fin || unackedBytes >= 2 * _sender.max_payload_size();
+    }
 
     // if the inbound stream ends before the outbound stream is at EOF
     // we do not need to linger after streams finish
@@ -54,7 +106,23 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
     // if ACK is set, send ackno and window_size to _sender
     if (seg.header().ack) {
-        _sender.ack_received(seg.header().ackno, seg.header().win);
+        // the window in a SYN segment is never scaled
+        const uint32_t window = static_cast<uint32_t>(seg.header().win) << (seg.header().syn ? 0 : sendShift);
+
+        // the echoed timestamp is the time the data this ACK covers was sent, so it gives an RTT
+        // sample even for a retransmission
+        optional<uint64_t> rtt;
+        if (timestampsEnabled && seg.header().options.timestamps) {
+            const uint32_t echoed = seg.header().options.timestamps->echo_reply;
+            const int32_t elapsed = static_cast<int32_t>(static_cast<uint32_t>(now) - echoed);
+            if (elapsed >= 0) {
+                rtt = elapsed;
+            }
+        }
+        _sender.ack_received(seg.header().ackno, window, seg.length_in_sequence_space() > 0, rtt);
+        if (sackEnabled) {
+            _sender.sack_received(seg.header().options.sack_blocks, seg.header().options.num_sack_blocks);
+        }
         if ((seg.header().ackno == seg.header().seqno) && seg.header().win == 0)
             return;
         safe_fill_window();
@@ -66,8 +134,10 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         _sender.send_empty_segment();
     }
 
-    // if segment has length in sequence space, ensure a segment is sent
-    if (seg.length_in_sequence_space() > 0 && _sender.segments_out().empty()) {
+    // if segment has length in sequence space, ensure a segment is sent (with delayed ACKs, only
+    // if it must be acknowledged now and no segment already carried the ACK)
+    if (seg.length_in_sequence_space() > 0 && _sender.segments_out().empty() &&
+        (!_cfg.delayed_ack || (ackNow && ackPending))) {
         _sender.send_empty_segment();
     }
 
@@ -92,19 +162,11 @@ bool TCPConnection::active() const {
     if (reset)
         return false;
 
-    // if inbound stream is not ended or there are still unassembled bytes, return true
-    if (!_receiver.stream_out().input_ended() || _receiver.unassembled_bytes() != 0)
-        return true;
-
-    // if outbound stream is not at EOF or FIN has not been sent, return true
-    if (!_sender.stream_in().eof() || _sender.next_seqno_absolute() != _sender.stream_in().bytes_written() + 2)
-        return true;
-
-    // if there are still bytes in flight, return true
-    if (_sender.bytes_in_flight() != 0)
+    // if either stream is still running, return true
+    if (!streams_finished())
         return true;
 
-    // if the three above conditions are true, and we do not need to linger, return false
+    // if the three conditions are false, and we do not need to linger, return false
     if (!_linger_after_streams_finish)
         return false;
 
@@ -115,6 +177,20 @@ bool TCPConnection::active() const {
     return true;
 }
 
+// returns false while any of the three prerequisites for active() holds
+bool TCPConnection::streams_finished() const {
+    // if inbound stream is not ended or there are still unassembled bytes, return false
+    if (!_receiver.stream_out().input_ended() || _receiver.unassembled_bytes() != 0)
+        return false;
+
+    // if outbound stream is not at EOF or FIN has not been sent, return false
+    if (!_sender.stream_in().eof() || _sender.next_seqno_absolute() != _sender.stream_in().bytes_written() + 2)
+        return false;
+
+    // if there are still bytes in flight, return false
+    return _sender.bytes_in_flight() == 0;
+}
+
 /*
  * Function Name: create_segment()
  * Description: This function pops a TCP segment off the _sender's segments_out queue.
@@ -122,17 +198,51 @@ bool TCPConnection::active() const {
  * the segment.
  */
 TCPSegment TCPConnection::create_segment() {
-    TCPSegment seg = _sender.segments_out().front();
+    TCPSegment seg = move(_sender.segments_out().front());
     _sender.segments_out().pop();
 
     // if SYN has been received, set ackno and ACK
     if (_receiver.ackno().has_value()) {
         seg.header().ackno = _receiver.ackno().value();
         seg.header().ack = true;
+        ackPending = false;
+        unackedBytes = 0;
     }
 
-    // set window size
-    seg.header().win = min(_receiver.window_size(), static_cast<size_t>(UINT16_MAX));
+    // set window size (scaled down, except on a SYN)
+    const uint8_t shift = seg.header().syn ? 0 : recvShift;
+    seg.header().win = min(_receiver.window_size() >> shift, static_cast<size_t>(UINT16_MAX));
+    if (seg.header().ack) {
+        _receiver.ack_sent(seg.header().ackno, static_cast<size_t>(seg.header().win) << shift);
+    }
+
+    // advertise our MSS if configured to, and offer SACK and window scaling (on a SYN/ACK,
+    // only if the peer offered them first)
+    if (seg.header().syn && _cfg.mss_option) {
+        seg.header().options.mss = static_cast<uint16_t>(min(_cfg.mss, static_cast<size_t>(UINT16_MAX)));
+    }
+    if (seg.header().syn && _cfg.sack && (!seg.header().ack || sackEnabled)) {
+        seg.header().options.sack_permitted = true;
+    }
+    if (seg.header().syn && _cfg.window_scaling && (!seg.header().ack || windowScalingEnabled)) {
+        seg.header().options.window_scale = TCPConfig::window_shift(_cfg.recv_capacity_limit());
+    }
+
+    // once timestamps are agreed (or on our SYN, to offer them), stamp every segment with our
+    // clock, and echo the peer's latest TSval
+    if (timestampsEnabled || (seg.header().syn && !seg.header().ack && _cfg.timestamps)) {
+        seg.header().options.timestamps = TCPTimestamps{static_cast<uint32_t>(now), _receiver.ts_recent().value_or(0)};
+    }
+
+    // once SACK is agreed, report the out-of-order data we hold on every ACK, in as many blocks as
+    // fit beside the payload without the segment outgrowing the MSS
+    if (sackEnabled && seg.header().ack) {
+        TCPOptions &options = seg.header().options;
+        const size_t room = segmentSize > seg.payload().size() ? segmentSize - seg.payload().size() : 0;
+        options.num_sack_blocks =
+            static_cast<uint8_t>(_receiver.sack_blocks(options.sack_blocks, options.sack_room(room)));
+    }
+    seg.header().doff = (TCPHeader::LENGTH + seg.header().options.length()) / 4;
     return seg;
 }
 
@@ -149,7 +259,7 @@ void TCPConnection::send_rst() {
     seg.header().rst = true;
 
     // push seg to _segments_out
-    _segments_out.push(seg);
+    _segments_out.push(move(seg));
 
     // set both byte streams to error
     _receiver.stream_out().set_error();
@@ -173,8 +283,7 @@ void TCPConnection::send_segments() {
     // push all segments from the _sender's segments_out queue to _segments_out
     // with proper ackno and window_size
     while (!_sender.segments_out().empty()) {
-        TCPSegment seg = create_segment();
-        _segments_out.push(seg);
+        _segments_out.push(create_segment());
     }
 }
 
@@ -197,14 +306,70 @@ size_t TCPConnection::write(const string &data) {
     return numWritten;
 }
 
+/*
+ * Function Name: write_from
+ * Args: FileDescriptor &fd
+ * Description: This function reads from fd straight into the free space of the
+ * _sender's Byte Stream, so the bytes are never staged in a temporary string,
+ * and then sends the TCP Segments created by the _sender to _segments_out.
+ */
+size_t TCPConnection::write_from(FileDescriptor &fd) {
+    ByteStream &outbound = _sender.stream_in();
+    const size_t numRead = fd.read_into(outbound.reserve_write(outbound.remaining_capacity()));
+    outbound.commit_write(numRead);
+    safe_fill_window();
+    return numRead;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
+    // advance the clock first, so a retransmission sent now carries the current TSval
+    now += ms_since_last_tick;
+
     // tells _sender that time has passed
     _sender.tick(ms_since_last_tick);
     send_segments();
 
+    // and _receiver, which may resize its buffer to the pace the reader drains it at
+    _receiver.tick(ms_since_last_tick, _sender.smoothed_rtt());
+
     // increment time_since_segment_received
     time_since_segment_received += ms_since_last_tick;
+
+    // a delayed ACK that no segment has carried goes out on its own once it has waited long enough
+    if (_cfg.delayed_ack && ackPending && !reset) {
+        ackDelay += ms_since_last_tick;
+        if (ackDelay >= _cfg.delayed_ack_timeout) {
+            _sender.send_empty_segment();
+            send_segments();
+            ackPending = false;
+            ackDelay = 0;
+        }
+    }
+}
+
+/*
+ * Function Name: time_until_deadline
+ * Description: This function returns the time until the earliest of the things tick() does:
+ * the sender's retransmission timer or pacing, sending a delayed ACK, and, once both streams
+ * have finished, ending the linger 10 times the initial retransmission timeout after the
+ * last segment was received. A connection with none of these pending needs no ticks.
+ */
+optional<size_t> TCPConnection::time_until_deadline() const {
+    if (!active()) {
+        return {};
+    }
+
+    optional<size_t> deadline = _sender.time_until_deadline();
+    const auto sooner = [&deadline](const size_t ms) { deadline = min(deadline.value_or(ms), ms); };
+    if (_cfg.delayed_ack && ackPending) {
+        sooner(ackDelay < _cfg.delayed_ack_timeout ? _cfg.delayed_ack_timeout - ackDelay : 0);
+    }
+    if (_linger_after_streams_finish && streams_finished()) {
+        const size_t linger = 10 * _cfg.rt_timeout;
+        sooner(time_since_segment_received < linger ? linger - time_since_segment_received : 0);
+    }
+    return deadline;
 }
 
 // ends outbound byte stream
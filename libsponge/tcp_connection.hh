@@ -1,6 +1,7 @@
 #ifndef SPONGE_LIBSPONGE_TCP_FACTORED_HH
 #define SPONGE_LIBSPONGE_TCP_FACTORED_HH
 
+#include "file_descriptor.hh"
 #include "tcp_config.hh"
 #include "tcp_receiver.hh"
 #include "tcp_sender.hh"
@@ -10,11 +11,11 @@
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity, _cfg.reassembler_backend, _cfg.recv_capacity_limit()};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
-    std::queue<TCPSegment> _segments_out{};
+    SegmentQueue _segments_out{};
 
     //! Should the TCPConnection stay active (and keep ACKing)
     //! for 10 * _cfg.rt_timeout milliseconds after both streams have ended,
@@ -30,12 +31,40 @@ class TCPConnection {
     // Number of milliseconds since the last segment was received
     size_t time_since_segment_received{0};
 
+    // true once both sides have offered SACK on their SYNs
+    bool sackEnabled{false};
+
+    // the most bytes of payload and options one segment may carry: our MSS, or the peer's if smaller
+    size_t segmentSize{_cfg.mss};
+
+    // window scaling, in effect once both sides have offered it on their SYNs:
+    // the peer's advertised windows are shifted left by sendShift, and ours right by recvShift
+    bool windowScalingEnabled{false};
+    uint8_t sendShift{0};
+    uint8_t recvShift{0};
+
+    // true once both sides have offered timestamps on their SYNs
+    bool timestampsEnabled{false};
+
+    // milliseconds since the connection was created (the sum of all ticks), the clock our TSvals
+    // come from; it starts at zero, so it says nothing about the host's uptime
+    uint64_t now{0};
+
+    // delayed ACKs: whether received data is waiting to be acknowledged, how many bytes of it,
+    // and for how many milliseconds it has waited (any segment we send acknowledges it)
+    bool ackPending{false};
+    size_t unackedBytes{0};
+    size_t ackDelay{0};
+
     TCPSegment create_segment();
     void send_segments();
 
     // sends a segment with RST flag set
     void send_rst();
 
+    // returns true once both streams have ended and everything we sent has been acknowledged
+    bool streams_finished() const;
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -47,6 +76,10 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Read data from `fd` directly into the outbound byte stream, and send it over TCP if possible
+    //! \returns the number of bytes read from `fd` (at most remaining_outbound_capacity())
+    size_t write_from(FileDescriptor &fd);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
@@ -70,6 +103,12 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief The sender's smoothed round-trip time in milliseconds, if it has measured one
+    std::optional<uint64_t> smoothed_rtt() const { return _sender.smoothed_rtt(); }
+    //! \brief The receiver's current capacity in bytes (which changes only with auto-tuning)
+    size_t receive_capacity() const { return _receiver.capacity(); }
+    //! \brief The sender's current retransmission timeout in milliseconds
+    unsigned int retransmission_timeout() const { return _sender.retransmission_timeout(); }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -83,11 +122,17 @@ class TCPConnection {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Milliseconds until tick() next has something to do, or empty if nothing is scheduled
+    //! \details The owner can wait this long (or until a segment arrives or data is written) before
+    //! calling tick(), instead of calling it at a fixed interval. Covers the sender's retransmission
+    //! timer and pacing, a delayed ACK, and the end of lingering after both streams finish.
+    std::optional<size_t> time_until_deadline() const;
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
     //! but could also be user datagrams (UDP) or any other kind).
-    std::queue<TCPSegment> &segments_out() { return _segments_out; }
+    SegmentQueue &segments_out() { return _segments_out; }
 
     //! \brief Is the connection still alive in any way?
     //! \returns `true` if either stream is still running or if the TCPConnection is lingering
@@ -40,6 +40,9 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! Milliseconds until tick() next has something to do, or empty if it never does
+    std::optional<size_t> time_until_deadline() const { return {}; }
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
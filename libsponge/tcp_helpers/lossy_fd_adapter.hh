@@ -66,6 +66,9 @@ class LossyFdAdapter {
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
+    std::optional<size_t> time_until_deadline() const {
+        return _adapter.time_until_deadline();
+    }  //!< FdAdapterBase::time_until_deadline passthrough
     //!@}
 };
 
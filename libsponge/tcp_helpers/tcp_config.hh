@@ -2,8 +2,11 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "congestion_control.hh"
+#include "stream_reassembler.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
@@ -12,14 +15,95 @@
 class TCPConfig {
   public:
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
-    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
+    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet (default MSS)
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t MIN_RTO_DFLT = 200;      //!< Default floor for the adaptive RTO (as in Linux)
+    static constexpr uint16_t MAX_RTO_DFLT = 60000;    //!< Default ceiling for the RTO (RFC 6298)
+    static constexpr uint16_t DELACK_DFLT = 40;        //!< Default delayed-ACK timeout (Linux's minimum)
+
+    //! Default limit for an auto-tuned receive buffer
+    static constexpr size_t MAX_RECV_CAPACITY_DFLT = 4 << 20;
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+
+    //! Adapt the retransmission timeout to measured round-trip times (RFC 6298), instead of
+    //! going back to `rt_timeout` after every acknowledgment
+    bool adaptive_rto = false;
+    uint16_t min_rto = MIN_RTO_DFLT;  //!< Smallest adaptive retransmission timeout, in ms (`max_rto` wins if lower)
+    //! Largest retransmission timeout, backed off or not, in milliseconds, in either mode; 0 means
+    //! MAX_RTO_DFLT with `adaptive_rto`, and (as before) no ceiling on the doubling without it
+    uint16_t max_rto = 0;
+
+    //! Congestion control for the sender; with None, only the receiver's window limits how much
+    //! is in flight
+    CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;
+
+    //! Retransmit the oldest outstanding segment after three duplicate ACKs instead of waiting for
+    //! the timer, and keep sending new data while that loss is repaired (RFC 5681, RFC 6582)
+    bool fast_retransmit = false;
+
+    //! Nagle's algorithm (RFC 896): while data is unacknowledged, hold back a segment smaller than
+    //! the MSS until the ACK arrives or enough is written to fill it, so small writes coalesce
+    bool nagle = false;
+
+    //! Delay the ACK for in-order data (RFC 1122 section 4.2.3.2), hoping to piggyback it on data we
+    //! send: an ACK still goes out once two full segments' worth is unacknowledged, or after
+    //! `delayed_ack_timeout`, and right away for a SYN, a FIN, or data out of order
+    bool delayed_ack = false;
+    uint16_t delayed_ack_timeout = DELACK_DFLT;  //!< Longest an ACK is delayed, in milliseconds (at most 500)
+
+    //! Maximum segment size: the largest payload we send, and (with `mss_option`) the MSS we advertise
+    //! on SYN. The sender is clamped to the peer's MSS option, whenever one arrives, if that is smaller.
+    size_t mss = MAX_PAYLOAD_SIZE;
+
+    //! Advertise `mss` with the MSS option on SYN; without it our SYNs carry no MSS option, as before
+    bool mss_option = false;
+
+    //! The MSS that fills, but doesn't exceed, an MTU of `mtu` bytes (IPv4 and TCP headers without options)
+    static constexpr size_t mss_for_mtu(const size_t mtu) { return mtu - 20 - 20; }
+
+    //! Where the receiver keeps out-of-order bytes; Bitmap preallocates a fixed-size ring per connection
+    StreamReassembler::Backend reassembler_backend = StreamReassembler::Backend::IntervalMap;
+
+    //! Offer selective acknowledgements (RFC 2018) on SYN, and use them if the peer offers them too
+    bool sack = false;
+
+    //! Offer window scaling (RFC 7323) on SYN, so a `recv_capacity` above 64 KiB can be advertised
+    //! in full; used only if the peer offers it too
+    bool window_scaling = false;
+
+    //! Offer the timestamps option (RFC 7323) on SYN; if the peer offers it too, every segment
+    //! carries one, RTT is measured from the echoed timestamps (retransmissions included), and
+    //! the receiver drops old duplicates whose sequence numbers have wrapped into the window (PAWS)
+    bool timestamps = false;
+
+    //! Receive buffer auto-tuning (dynamic right-sizing): start with `recv_capacity`, grow it towards
+    //! `max_recv_capacity` while the reader keeps up with a sender that the window holds back, and
+    //! shrink it again when the connection idles (see TCPReceiver::tick()). Needs window scaling to
+    //! advertise more than 64 KiB.
+    bool recv_autotuning = false;
+    size_t max_recv_capacity = MAX_RECV_CAPACITY_DFLT;  //!< Largest auto-tuned receive capacity, in bytes
+
+    //! The most the receive buffer can ever hold
+    size_t recv_capacity_limit() const {
+        return recv_autotuning ? std::max(recv_capacity, max_recv_capacity) : recv_capacity;
+    }
+
+    //! Largest window scale shift allowed by RFC 7323
+    static constexpr uint8_t MAX_WINDOW_SHIFT = 14;
+
+    //! The smallest shift that lets a window of `capacity` bytes fit the 16-bit window field
+    static constexpr uint8_t window_shift(const size_t capacity) {
+        uint8_t shift = 0;
+        while (shift < MAX_WINDOW_SHIFT and (capacity >> shift) > UINT16_MAX) {
+            shift++;
+        }
+        return shift;
+    }
 };
 
 //! Config for classes derived from FdAdapter
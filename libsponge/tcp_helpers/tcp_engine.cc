@@ -0,0 +1,261 @@
+#include "tcp_engine.hh"
+
+#include "parser.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_state.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+size_t TCPFourTupleHash::operator()(const TCPFourTuple &tuple) const {
+    const uint64_t local = (uint64_t{tuple.local_address} << 16) | tuple.local_port;
+    const uint64_t remote = (uint64_t{tuple.remote_address} << 16) | tuple.remote_port;
+    return hash<uint64_t>{}(local * 0x9e3779b97f4a7c15 ^ remote);
+}
+
+TCPEngine::Connection &TCPEngine::_find(const ConnectionId id) {
+    const auto it = _connections.find(id);
+    if (it == _connections.end()) {
+        throw runtime_error("TCPEngine: no connection " + to_string(id));
+    }
+    return it->second;
+}
+
+TCPEngine::Connection &TCPEngine::_add(const ConnectionId id, const TCPFourTuple &tuple, const TCPConfig &config) {
+    _by_tuple.emplace(tuple, id);
+    return _connections.try_emplace(id, tuple, config, _now).first->second;
+}
+
+void TCPEngine::_catch_up(Connection &conn) {
+    if (_now > conn.lastTick) {
+        conn.tcp.tick(_now - conn.lastTick);
+        conn.lastTick = _now;
+    }
+}
+
+void TCPEngine::_service(const ConnectionId id, Connection &conn) {
+    SegmentQueue &segments = conn.tcp.segments_out();
+    while (not segments.empty()) {
+        _datagrams_out.push(TCPOverIPv4Adapter::wrap_tcp_in_ip(segments.front(),
+                                                               conn.tuple.local_address,
+                                                               conn.tuple.local_port,
+                                                               conn.tuple.remote_address,
+                                                               conn.tuple.remote_port));
+        segments.pop();
+    }
+
+    // a handshake a listener started ends in its accept queue, or (if it failed) with the connection's removal
+    if (conn.listenPort and conn.tcp.active()) {
+        const TCPState::State states[] = {TCPState::State::LISTEN, TCPState::State::SYN_RCVD};
+        if (none_of(begin(states), end(states), [&](const auto state) { return conn.tcp.state() == state; })) {
+            Listener &listener = _listeners.at(*conn.listenPort);
+            listener.pending--;
+            listener.acceptQueue.push_back(id);
+            conn.listenPort.reset();
+        }
+    }
+
+    if (not conn.tcp.active()) {
+        _timers.cancel(id);
+        if (conn.listenPort or conn.released) {
+            _remove(id, conn);
+        }
+        return;
+    }
+
+    if (const auto ms = conn.tcp.time_until_deadline()) {
+        _timers.schedule(id, _now + *ms);
+    } else {
+        _timers.cancel(id);
+    }
+}
+
+void TCPEngine::_remove(const ConnectionId id, Connection &conn) {
+    if (conn.listenPort) {
+        _listeners.at(*conn.listenPort).pending--;
+    }
+    _timers.cancel(id);
+    _by_tuple.erase(conn.tuple);
+    _connections.erase(id);
+}
+
+void TCPEngine::_send_reset(const TCPFourTuple &tuple, const TCPSegment &seg) {
+    // never answer a RST, so two closed ports can't bounce them back and forth
+    if (seg.header().rst) {
+        return;
+    }
+
+    // take the seqno the segment expects, or acknowledge it if it expects nothing (RFC 793 "Reset Generation")
+    TCPSegment rst;
+    rst.header().rst = true;
+    if (seg.header().ack) {
+        rst.header().seqno = seg.header().ackno;
+    } else {
+        rst.header().ack = true;
+        rst.header().ackno = seg.header().seqno + seg.length_in_sequence_space();
+    }
+    _datagrams_out.push(TCPOverIPv4Adapter::wrap_tcp_in_ip(
+        rst, tuple.local_address, tuple.local_port, tuple.remote_address, tuple.remote_port));
+}
+
+TCPEngine::ConnectionId TCPEngine::connect(const TCPConfig &config, const Address &local, const Address &remote) {
+    const TCPFourTuple tuple{local.ipv4_numeric(), local.port(), remote.ipv4_numeric(), remote.port()};
+    if (_by_tuple.count(tuple)) {
+        throw runtime_error("TCPEngine::connect(): " + local.to_string() + " is already connected to " +
+                            remote.to_string());
+    }
+
+    const ConnectionId id = _next_id++;
+    Connection &conn = _add(id, tuple, config);
+    conn.tcp.connect();
+    _service(id, conn);
+    return id;
+}
+
+void TCPEngine::listen(const TCPConfig &config, const Address &local, const size_t backlog) {
+    if (_listeners.count(local.port())) {
+        throw runtime_error("TCPEngine::listen(): already listening on port " + to_string(local.port()));
+    }
+    _listeners.emplace(local.port(), Listener{config, local.ipv4_numeric(), backlog, 0, {}});
+}
+
+optional<TCPEngine::ConnectionId> TCPEngine::accept(const uint16_t port) {
+    const auto it = _listeners.find(port);
+    if (it == _listeners.end() or it->second.acceptQueue.empty()) {
+        return {};
+    }
+    const ConnectionId id = it->second.acceptQueue.front();
+    it->second.acceptQueue.pop_front();
+    return id;
+}
+
+size_t TCPEngine::write(const ConnectionId id, const string &data) {
+    Connection &conn = _find(id);
+    _catch_up(conn);
+    const size_t written = conn.tcp.write(data);
+    _service(id, conn);
+    return written;
+}
+
+void TCPEngine::end_input_stream(const ConnectionId id) {
+    Connection &conn = _find(id);
+    _catch_up(conn);
+    conn.tcp.end_input_stream();
+    _service(id, conn);
+}
+
+void TCPEngine::release(const ConnectionId id) {
+    Connection &conn = _find(id);
+    conn.released = true;
+    _catch_up(conn);
+    conn.tcp.end_input_stream();
+    _service(id, conn);
+}
+
+//! \details A datagram that isn't TCP or doesn't parse is dropped. A segment for an existing
+//! connection goes to it, after the connection has been ticked up to the engine's clock so its
+//! timers are current; a SYN for a port we listen on (with room in the backlog) starts a new
+//! connection; anything else is answered with a RST.
+void TCPEngine::datagram_received(const InternetDatagram &dgram) {
+    TCPSegment seg;
+    if (dgram.header().proto != IPv4Header::PROTO_TCP or
+        seg.parse(dgram.payload(), dgram.header().pseudo_cksum()) != ParseResult::NoError) {
+        _dropped++;
+        return;
+    }
+
+    const TCPFourTuple tuple{dgram.header().dst, seg.header().dport, dgram.header().src, seg.header().sport};
+    if (const auto it = _by_tuple.find(tuple); it != _by_tuple.end()) {
+        const ConnectionId id = it->second;
+        Connection &conn = _connections.at(id);
+        _catch_up(conn);
+        conn.tcp.segment_received(seg);
+
+        // a RST is never answered, as that could start two hosts trading segments forever
+        if (seg.header().rst) {
+            SegmentQueue &replies = conn.tcp.segments_out();
+            while (not replies.empty()) {
+                replies.pop();
+            }
+        }
+        _service(id, conn);
+        return;
+    }
+
+    const auto listener = _listeners.find(tuple.local_port);
+    const bool opening = seg.header().syn and not seg.header().ack and not seg.header().rst;
+    if (not opening or listener == _listeners.end() or
+        (listener->second.address != 0 and listener->second.address != tuple.local_address)) {
+        _dropped++;
+        _send_reset(tuple, seg);
+        return;
+    }
+
+    // a full backlog drops the SYN without a RST, so the peer retransmits it later
+    Listener &owner = listener->second;
+    if (owner.pending + owner.acceptQueue.size() >= owner.backlog) {
+        _dropped++;
+        return;
+    }
+
+    const ConnectionId id = _next_id++;
+    Connection &conn = _add(id, tuple, owner.config);
+    conn.listenPort = tuple.local_port;
+    owner.pending++;
+    conn.tcp.segment_received(seg);
+    _service(id, conn);
+}
+
+void TCPEngine::advance(const uint64_t now_ms) {
+    _now = max(_now, now_ms);
+    _timers.advance(_now, _expired);
+    for (const TimerWheel::Key id : _expired) {
+        const auto it = _connections.find(id);
+        if (it != _connections.end()) {
+            _catch_up(it->second);
+            _service(id, it->second);
+        }
+    }
+    _expired.clear();
+}
+
+void TCPEngine::run(FileDescriptor &tun, EventLoop &eventloop, const function<bool()> &condition) {
+    // inbound datagrams go to their connections, with the clock moved up to when they arrived
+    eventloop.add_rule(tun, Direction::In, [&] {
+        advance(timestamp_ms());
+        InternetDatagram dgram;
+        if (dgram.parse(tun.read()) == ParseResult::NoError) {
+            datagram_received(dgram);
+        } else {
+            _dropped++;
+        }
+    });
+
+    // and every connection's segments leave through the same device
+    eventloop.add_rule(
+        tun,
+        Direction::Out,
+        [&] {
+            while (not _datagrams_out.empty()) {
+                tun.write(_datagrams_out.front().serialize());
+                _datagrams_out.pop();
+            }
+        },
+        [&] { return not _datagrams_out.empty(); });
+
+    while (condition()) {
+        const uint64_t now = timestamp_ms();
+        advance(now);
+        uint64_t wait = MAX_WAIT_MS;
+        if (const auto deadline = next_deadline()) {
+            wait = min(wait, *deadline > now ? *deadline - now : 0);
+        }
+        if (eventloop.wait_next_event(static_cast<int>(wait)) == EventLoop::Result::Exit) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,200 @@
+#ifndef SPONGE_LIBSPONGE_TCP_ENGINE_HH
+#define SPONGE_LIBSPONGE_TCP_ENGINE_HH
+
+#include "address.hh"
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "ipv4_datagram.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "timer_wheel.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//! \brief The addresses and ports that identify a TCP connection, from our side
+struct TCPFourTuple {
+    uint32_t local_address = 0;   //!< Our IPv4 address (numeric)
+    uint16_t local_port = 0;      //!< Our port (host byte order)
+    uint32_t remote_address = 0;  //!< The peer's IPv4 address (numeric)
+    uint16_t remote_port = 0;     //!< The peer's port (host byte order)
+
+    bool operator==(const TCPFourTuple &other) const {
+        return local_address == other.local_address and local_port == other.local_port and
+               remote_address == other.remote_address and remote_port == other.remote_port;
+    }
+};
+
+//! \brief Hashes a TCPFourTuple, for unordered containers
+struct TCPFourTupleHash {
+    size_t operator()(const TCPFourTuple &tuple) const;
+};
+
+//! \brief Many TCPConnections sharing one stream of IPv4 datagrams, all driven by one thread
+//!
+//! Where each TCPSpongeSocket runs one connection on a thread of its own, the engine owns any
+//! number of them, keyed by four-tuple. Datagrams that arrive are demultiplexed to their
+//! connection, a SYN to a port we listen on starts a new one (which joins that port's accept
+//! queue once its handshake completes), and every connection's segments leave through one queue
+//! of datagrams. Connections keep their deadlines in one TimerWheel, so a connection is only
+//! touched when something happens to it: an idle one costs its state machine and buffers and
+//! nothing else.
+//!
+//! The engine itself does no I/O, and its clock only moves when advance() is called; run() is a
+//! loop that drives it from a TUN device.
+class TCPEngine {
+  public:
+    //! Identifies a connection for as long as the engine keeps it
+    using ConnectionId = TimerWheel::Key;
+
+    //! Connections a listening port holds, between SYN and accept(), unless listen() says otherwise
+    static constexpr size_t DEFAULT_BACKLOG = 128;
+
+    //! Longest run() sleeps when no timer is due sooner, so it notices `condition`
+    static constexpr uint64_t MAX_WAIT_MS = 100;
+
+  private:
+    struct Connection {
+        TCPFourTuple tuple;
+        TCPConnection tcp;
+
+        // the engine's clock when tcp was last ticked
+        uint64_t lastTick;
+
+        // set while the handshake of a connection started by a listener is in progress
+        std::optional<uint16_t> listenPort;
+
+        // the application is done with the connection: it is removed once it stops being active
+        bool released;
+
+        // constructs the TCPConnection in place, as a moved-from one would warn when destroyed
+        Connection(const TCPFourTuple &tuple_, const TCPConfig &config, const uint64_t now)
+            : tuple(tuple_), tcp(config), lastTick(now), listenPort(), released(false) {}
+    };
+
+    struct Listener {
+        TCPConfig config;
+        uint32_t address;                       // 0 to accept connections to any of our addresses
+        size_t backlog;                         // most connections that may be pending and queued together
+        size_t pending;                         // connections whose handshakes are in progress
+        std::deque<ConnectionId> acceptQueue;  // established connections, waiting for accept()
+    };
+
+    std::unordered_map<ConnectionId, Connection> _connections{};
+    std::unordered_map<TCPFourTuple, ConnectionId, TCPFourTupleHash> _by_tuple{};
+    std::unordered_map<uint16_t, Listener> _listeners{};
+
+    //! The id the next connection gets
+    ConnectionId _next_id{0};
+
+    //! Each active connection's next deadline, keyed by its id
+    TimerWheel _timers{};
+
+    //! Keys of the timers that expired in the latest advance()
+    std::vector<TimerWheel::Key> _expired{};
+
+    //! Milliseconds, as passed to advance()
+    uint64_t _now{0};
+
+    //! Outbound datagrams, from all connections
+    std::queue<InternetDatagram> _datagrams_out{};
+
+    //! Total segments (and RSTs) dropped by the demultiplexer
+    uint64_t _dropped{0};
+
+    //! Finds a connection, or throws if there is none with that id
+    Connection &_find(const ConnectionId id);
+
+    //! Creates a connection for `tuple`
+    Connection &_add(const ConnectionId id, const TCPFourTuple &tuple, const TCPConfig &config);
+
+    //! Ticks a connection up to the engine's clock, before it handles anything else
+    void _catch_up(Connection &conn);
+
+    //! After a connection has handled something: send its segments, move it to its accept queue if
+    //! it became established, reschedule its timer, and remove it if it is finished
+    void _service(const ConnectionId id, Connection &conn);
+
+    //! Removes a connection
+    void _remove(const ConnectionId id, Connection &conn);
+
+    //! Answers a segment that belongs to no connection with a RST, as a closed port does
+    void _send_reset(const TCPFourTuple &tuple, const TCPSegment &seg);
+
+  public:
+    //! \name Connections
+    //!@{
+
+    //! \brief Open a connection from `local` to `remote`, sending a SYN
+    //! \returns the connection's id
+    ConnectionId connect(const TCPConfig &config, const Address &local, const Address &remote);
+
+    //! \brief Accept connections to `local`'s port (on `local`'s address, or on any address if that is 0.0.0.0)
+    //! \param backlog the most connections that may be handshaking or waiting for accept() at once;
+    //! SYNs beyond that are dropped, so the peer tries again later
+    void listen(const TCPConfig &config, const Address &local, const size_t backlog = DEFAULT_BACKLOG);
+
+    //! \brief The oldest established connection to `port` that hasn't been accepted yet, if any
+    std::optional<ConnectionId> accept(const uint16_t port);
+
+    //! \brief Write to a connection's outbound stream
+    //! \returns the number of bytes written
+    size_t write(const ConnectionId id, const std::string &data);
+
+    //! \brief End a connection's outbound stream
+    void end_input_stream(const ConnectionId id);
+
+    //! \brief Hand a connection back to the engine, ending its outbound stream: the engine lets it
+    //! finish (including lingering), then removes it
+    void release(const ConnectionId id);
+
+    //! \brief A connection, to read its inbound stream or inspect it
+    //! \note Write to it with write() and end_input_stream() instead of directly, so the segments
+    //! it sends and its timer are seen to.
+    TCPConnection &connection(const ConnectionId id) { return _find(id).tcp; }
+
+    //! \brief The addresses and ports of a connection
+    const TCPFourTuple &four_tuple(const ConnectionId id) { return _find(id).tuple; }
+
+    //! \brief Whether the engine has a connection with this id (it removes connections once they
+    //! finish, if they were released or never accepted)
+    bool contains(const ConnectionId id) const { return _connections.count(id) > 0; }
+
+    //! \brief The number of connections the engine holds
+    size_t size() const { return _connections.size(); }
+    //!@}
+
+    //! \name Datagrams and time
+    //!@{
+
+    //! \brief Demultiplex a datagram to its connection (or a listener), ticking the connection first
+    void datagram_received(const InternetDatagram &dgram);
+
+    //! \brief Datagrams the connections have sent, for the owner to put on the wire
+    std::queue<InternetDatagram> &datagrams_out() { return _datagrams_out; }
+
+    //! \brief Move the engine's clock to `now_ms`, ticking the connections whose deadlines have come
+    void advance(const uint64_t now_ms);
+
+    //! \brief When advance() next has something to do, or empty if no connection has a deadline
+    std::optional<uint64_t> next_deadline() const { return _timers.next_deadline(); }
+
+    //! \brief Segments that belonged to no connection or listener, or didn't parse
+    uint64_t dropped() const { return _dropped; }
+
+    //! \brief Read datagrams from `tun`, and write the engine's to it, while `condition` holds
+    //! \details Adds two rules to `eventloop` and then runs it, sleeping until a datagram arrives,
+    //! a rule the application added to `eventloop` fires, or the earliest deadline. Call it once
+    //! for each `eventloop`.
+    void run(FileDescriptor &tun, EventLoop &eventloop, const std::function<bool()> &condition);
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_ENGINE_HH
@@ -1,6 +1,7 @@
 #include "tcp_header.hh"
 
 #include <sstream>
+#include <string_view>
 
 using namespace std;
 
@@ -37,13 +38,21 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
+    // the options (if any) are decoded in place from the parser's buffer
+    if (doff == LENGTH / 4) {
+        options = {};
+        return p.get_error();
+    }
+
+    const Buffer optionBytes = p.buffer();
     p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
 
     if (p.error()) {
         return p.get_error();
     }
 
+    options.parse(string_view(optionBytes.str()).substr(0, doff * 4 - TCPHeader::LENGTH));
+
     return ParseResult::NoError;
 }
 
@@ -72,7 +81,12 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    // options only go in if doff says there's room for them (setting doff to 5 strips them)
+    if (doff > LENGTH / 4 and !options.empty() and LENGTH + options.length() <= 4 * doff) {
+        options.serialize(ret);
+    }
+
+    ret.resize(4 * doff);  // expand header to advertised size (zero bytes are End of Option List)
 
     return ret;
 }
@@ -89,14 +103,19 @@ string TCPHeader::to_string() const {
        << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP options: " << options.to_string() << '\n';
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (!options.empty()) {
+        ss << ",options=" << options.to_string();
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +123,5 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && options == other.options;
 }
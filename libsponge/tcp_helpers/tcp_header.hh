@@ -2,10 +2,10 @@
 #define SPONGE_LIBSPONGE_TCP_HEADER_HH
 
 #include "parser.hh"
+#include "tcp_options.hh"
 #include "wrapping_integers.hh"
 
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
 
@@ -50,6 +50,11 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \brief TCP options
+    //! \note These are only serialized if `doff` leaves room for them, so after changing
+    //! them set `doff` to `(LENGTH + options.length()) / 4`.
+    TCPOptions options{};
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
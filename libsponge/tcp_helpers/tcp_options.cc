@@ -0,0 +1,189 @@
+#include "tcp_options.hh"
+
+#include "parser.hh"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+// option lengths (including the kind and length bytes) from RFC 793, 2018, and 7323
+static constexpr uint8_t MSS_LEN = 4;
+static constexpr uint8_t WINDOW_SCALE_LEN = 3;
+static constexpr uint8_t SACK_PERMITTED_LEN = 2;
+static constexpr uint8_t TIMESTAMPS_LEN = 10;
+static constexpr uint8_t SACK_BLOCK_LEN = 8;
+
+// reads a big-endian integer from the option bytes in place
+template <typename T>
+static T read_int(const string_view bytes, const size_t at) {
+    T ret = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        ret = (ret << 8) | static_cast<uint8_t>(bytes[at + i]);
+    }
+    return ret;
+}
+
+// the number of bytes the options take up before padding, optionally leaving out the SACK blocks
+static size_t unpadded_length(const TCPOptions &options, const bool withSackBlocks) {
+    size_t len = options.unknown_length;
+    if (options.mss) {
+        len += MSS_LEN;
+    }
+    if (options.sack_permitted or options.timestamps) {
+        // SACK-permitted and timestamps share a word, or are each padded by two NOPs
+        len += (options.sack_permitted and options.timestamps) ? SACK_PERMITTED_LEN + TIMESTAMPS_LEN
+               : options.timestamps                             ? 2 + TIMESTAMPS_LEN
+                                                                : 2 + SACK_PERMITTED_LEN;
+    }
+    if (options.window_scale) {
+        len += 1 + WINDOW_SCALE_LEN;
+    }
+    if (withSackBlocks and options.num_sack_blocks > 0) {
+        len += 2 + 2 + SACK_BLOCK_LEN * options.num_sack_blocks;
+    }
+    return len;
+}
+
+size_t TCPOptions::length() const { return (unpadded_length(*this, true) + 3) / 4 * 4; }
+
+//! \param[in] limit the option bytes available (the padding counts), capped at MAX_LENGTH
+size_t TCPOptions::sack_room(const size_t limit) const {
+    const size_t space = min(limit, MAX_LENGTH) / 4 * 4;
+    const size_t used = unpadded_length(*this, false) + 2 + 2;
+    return used >= space ? 0 : min(MAX_SACK_BLOCKS, (space - used) / SACK_BLOCK_LEN);
+}
+
+//! \param[in] bytes the option bytes of the header
+void TCPOptions::parse(const string_view bytes) {
+    *this = TCPOptions{};
+
+    size_t i = 0;
+    while (i < bytes.size()) {
+        const uint8_t kind = static_cast<uint8_t>(bytes[i]);
+        if (kind == KIND_END) {
+            break;
+        }
+        if (kind == KIND_NOP) {
+            i++;
+            continue;
+        }
+
+        // every other option has a length byte that counts the kind and length bytes too
+        if (i + 1 >= bytes.size()) {
+            break;
+        }
+        const uint8_t len = static_cast<uint8_t>(bytes[i + 1]);
+        if (len < 2 or i + len > bytes.size()) {
+            break;
+        }
+
+        if (kind == KIND_MSS and len == MSS_LEN) {
+            mss = read_int<uint16_t>(bytes, i + 2);
+        } else if (kind == KIND_WINDOW_SCALE and len == WINDOW_SCALE_LEN) {
+            window_scale = static_cast<uint8_t>(bytes[i + 2]);
+        } else if (kind == KIND_SACK_PERMITTED and len == SACK_PERMITTED_LEN) {
+            sack_permitted = true;
+        } else if (kind == KIND_TIMESTAMPS and len == TIMESTAMPS_LEN) {
+            timestamps = TCPTimestamps{read_int<uint32_t>(bytes, i + 2), read_int<uint32_t>(bytes, i + 6)};
+        } else if (kind == KIND_SACK and len > 2 and (len - 2) % SACK_BLOCK_LEN == 0) {
+            for (size_t at = i + 2; at < i + len and num_sack_blocks < MAX_SACK_BLOCKS; at += SACK_BLOCK_LEN) {
+                sack_blocks[num_sack_blocks].left = WrappingInt32{read_int<uint32_t>(bytes, at)};
+                sack_blocks[num_sack_blocks].right = WrappingInt32{read_int<uint32_t>(bytes, at + 4)};
+                num_sack_blocks++;
+            }
+        } else if (unknown_length + len <= MAX_LENGTH) {
+            // keep anything we don't decode (including a known kind with the wrong length) as is
+            copy(bytes.begin() + i, bytes.begin() + i + len, unknown.begin() + unknown_length);
+            unknown_length += len;
+        }
+
+        i += len;
+    }
+}
+
+//! \param[in,out] s the serialized header so far; the options are appended to it
+void TCPOptions::serialize(string &s) const {
+    const size_t start = s.size();
+
+    if (mss) {
+        NetUnparser::u8(s, KIND_MSS);
+        NetUnparser::u8(s, MSS_LEN);
+        NetUnparser::u16(s, *mss);
+    }
+
+    if (sack_permitted and timestamps) {
+        NetUnparser::u8(s, KIND_SACK_PERMITTED);
+        NetUnparser::u8(s, SACK_PERMITTED_LEN);
+    } else if (sack_permitted or timestamps) {
+        NetUnparser::u8(s, KIND_NOP);
+        NetUnparser::u8(s, KIND_NOP);
+        if (sack_permitted) {
+            NetUnparser::u8(s, KIND_SACK_PERMITTED);
+            NetUnparser::u8(s, SACK_PERMITTED_LEN);
+        }
+    }
+    if (timestamps) {
+        NetUnparser::u8(s, KIND_TIMESTAMPS);
+        NetUnparser::u8(s, TIMESTAMPS_LEN);
+        NetUnparser::u32(s, timestamps->value);
+        NetUnparser::u32(s, timestamps->echo_reply);
+    }
+
+    if (window_scale) {
+        NetUnparser::u8(s, KIND_NOP);
+        NetUnparser::u8(s, KIND_WINDOW_SCALE);
+        NetUnparser::u8(s, WINDOW_SCALE_LEN);
+        NetUnparser::u8(s, *window_scale);
+    }
+
+    if (num_sack_blocks > 0) {
+        // two NOPs keep the blocks 32-bit aligned
+        NetUnparser::u8(s, KIND_NOP);
+        NetUnparser::u8(s, KIND_NOP);
+        NetUnparser::u8(s, KIND_SACK);
+        NetUnparser::u8(s, 2 + SACK_BLOCK_LEN * num_sack_blocks);
+        for (size_t i = 0; i < num_sack_blocks; i++) {
+            NetUnparser::u32(s, sack_blocks[i].left.raw_value());
+            NetUnparser::u32(s, sack_blocks[i].right.raw_value());
+        }
+    }
+
+    s.append(unknown.begin(), unknown.begin() + unknown_length);
+
+    // pad with End of Option List bytes
+    s.resize(start + length(), KIND_END);
+}
+
+//! \returns A string listing the options that are set
+string TCPOptions::to_string() const {
+    stringstream ss{};
+    if (mss) {
+        ss << " mss=" << *mss;
+    }
+    if (window_scale) {
+        ss << " wscale=" << +*window_scale;
+    }
+    if (sack_permitted) {
+        ss << " sackOK";
+    }
+    if (timestamps) {
+        ss << " ts=" << timestamps->value << "/" << timestamps->echo_reply;
+    }
+    for (size_t i = 0; i < num_sack_blocks; i++) {
+        ss << " sack=[" << sack_blocks[i].left << "," << sack_blocks[i].right << ")";
+    }
+    if (unknown_length > 0) {
+        ss << " unknown=" << +unknown_length << "B";
+    }
+    const string ret = ss.str();
+    return ret.empty() ? ret : ret.substr(1);
+}
+
+bool TCPOptions::operator==(const TCPOptions &other) const {
+    return mss == other.mss and window_scale == other.window_scale and sack_permitted == other.sack_permitted and
+           timestamps == other.timestamps and num_sack_blocks == other.num_sack_blocks and
+           equal(sack_blocks.begin(), sack_blocks.begin() + num_sack_blocks, other.sack_blocks.begin()) and
+           unknown_length == other.unknown_length and
+           equal(unknown.begin(), unknown.begin() + unknown_length, other.unknown.begin());
+}
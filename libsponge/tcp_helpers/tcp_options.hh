@@ -0,0 +1,95 @@
+#ifndef SPONGE_LIBSPONGE_TCP_OPTIONS_HH
+#define SPONGE_LIBSPONGE_TCP_OPTIONS_HH
+
+#include "wrapping_integers.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+//! \brief A block of data the receiver holds beyond the ackno, as reported by a SACK option
+//! \details Covers the sequence numbers [left, right), as in RFC 2018.
+struct TCPSackBlock {
+    WrappingInt32 left{0};   //!< first sequence number of the block
+    WrappingInt32 right{0};  //!< sequence number immediately following the block
+
+    bool operator==(const TCPSackBlock &other) const { return left == other.left and right == other.right; }
+};
+
+//! \brief The values carried by a timestamps option (RFC 7323)
+struct TCPTimestamps {
+    uint32_t value = 0;       //!< TSval: the sender's clock when the segment was sent
+    uint32_t echo_reply = 0;  //!< TSecr: the most recent TSval received from the peer
+
+    bool operator==(const TCPTimestamps &other) const {
+        return value == other.value and echo_reply == other.echo_reply;
+    }
+};
+
+//! \brief The options of a [TCP](\ref rfc::rfc793) header, decoded into typed fields
+//!
+//! Everything is stored inline in fixed-size members, so parsing, building, or copying a set
+//! of options never allocates. Options that are not decoded here are kept byte-for-byte (in
+//! the order they arrived) and written back out unchanged.
+struct TCPOptions {
+    static constexpr size_t MAX_LENGTH = 40;        //!< Option space in a TCP header, in bytes
+    static constexpr size_t MAX_SACK_BLOCKS = 4;    //!< Most SACK blocks that fit in the option space
+    static constexpr size_t TIMESTAMPS_SPACE = 12;  //!< Option space timestamps take, with their padding
+
+    //! \name Option kinds
+    //!@{
+    static constexpr uint8_t KIND_END = 0;             //!< End of Option List
+    static constexpr uint8_t KIND_NOP = 1;             //!< No-Operation (padding)
+    static constexpr uint8_t KIND_MSS = 2;             //!< Maximum Segment Size (SYN only)
+    static constexpr uint8_t KIND_WINDOW_SCALE = 3;    //!< Window Scale (SYN only)
+    static constexpr uint8_t KIND_SACK_PERMITTED = 4;  //!< SACK-Permitted (SYN only)
+    static constexpr uint8_t KIND_SACK = 5;            //!< Selective Acknowledgment blocks
+    static constexpr uint8_t KIND_TIMESTAMPS = 8;      //!< Timestamps
+    //!@}
+
+    //! \name Decoded options
+    //!@{
+    std::optional<uint16_t> mss{};                            //!< MSS option
+    std::optional<uint8_t> window_scale{};                    //!< Window scale option (shift count)
+    bool sack_permitted = false;                              //!< SACK-permitted option
+    std::optional<TCPTimestamps> timestamps{};                //!< Timestamps option
+    uint8_t num_sack_blocks = 0;                              //!< Number of valid entries in `sack_blocks`
+    std::array<TCPSackBlock, MAX_SACK_BLOCKS> sack_blocks{};  //!< SACK option blocks
+    //!@}
+
+    //! \name Options that are not decoded, each still prefixed by its kind and length bytes
+    //!@{
+    uint8_t unknown_length = 0;                 //!< Number of valid bytes in `unknown`
+    std::array<uint8_t, MAX_LENGTH> unknown{};  //!< Raw bytes of the undecoded options
+    //!@}
+
+    //! \brief Decode options from the bytes between the fixed header and the payload
+    //! \details Reads `bytes` in place. An option that is malformed (or runs past the end)
+    //! stops parsing, so a bad option never makes the rest of the segment unparseable.
+    void parse(const std::string_view bytes);
+
+    //! Append the options to `s` (whose capacity the caller has reserved), padded to a multiple of 4 bytes
+    void serialize(std::string &s) const;
+
+    //! Number of bytes serialize() writes
+    size_t length() const;
+
+    //! How many SACK blocks still fit alongside the other options, in at most `limit` bytes of options
+    size_t sack_room(const size_t limit = MAX_LENGTH) const;
+
+    //! True if no option is set
+    bool empty() const {
+        return not mss and not window_scale and not sack_permitted and not timestamps and num_sack_blocks == 0 and
+               unknown_length == 0;
+    }
+
+    //! Return a string with a short human-readable list of the options
+    std::string to_string() const;
+
+    bool operator==(const TCPOptions &other) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_OPTIONS_HH
@@ -73,14 +73,28 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
 //! \param[in] seg is the TCP segment to convert
 InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+    return wrap_tcp_in_ip(seg,
+                          config().source.ipv4_numeric(),
+                          config().source.port(),
+                          config().destination.ipv4_numeric(),
+                          config().destination.port());
+}
+
+//! \param[in] seg is the TCP segment to convert
+//! \param[in] src is the source address
+//! \param[in] sport is the source port
+//! \param[in] dst is the destination address
+//! \param[in] dport is the destination port
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(
+    TCPSegment &seg, const uint32_t src, const uint16_t sport, const uint32_t dst, const uint16_t dport) {
     // set the port numbers in the TCP segment
-    seg.header().sport = config().source.port();
-    seg.header().dport = config().destination.port();
+    seg.header().sport = sport;
+    seg.header().dport = dport;
 
     // create an Internet Datagram and set its addresses and length
     InternetDatagram ip_dgram;
-    ip_dgram.header().src = config().source.ipv4_numeric();
-    ip_dgram.header().dst = config().destination.ipv4_numeric();
+    ip_dgram.header().src = src;
+    ip_dgram.header().dst = dst;
     ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
 
     // set payload, calculating TCP checksum using information from IP header
@@ -6,6 +6,7 @@
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
+#include <cstdint>
 #include <optional>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
@@ -14,6 +15,14 @@ class TCPOverIPv4Adapter : public FdAdapterBase {
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! Sets the segment's ports and wraps it in an IPv4 datagram from `src`:`sport` to `dst`:`dport`
+    //! (addresses numeric, ports in host byte order)
+    static InternetDatagram wrap_tcp_in_ip(TCPSegment &seg,
+                                           const uint32_t src,
+                                           const uint16_t sport,
+                                           const uint32_t dst,
+                                           const uint16_t dport);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -2,9 +2,11 @@
 #define SPONGE_LIBSPONGE_TCP_SEGMENT_HH
 
 #include "buffer.hh"
+#include "ring_buffer.hh"
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <queue>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
@@ -33,4 +35,8 @@ class TCPSegment {
     size_t length_in_sequence_space() const;
 };
 
+//! \brief Segments waiting to be sent, oldest first
+//! \note Reuses its storage, so a connection doesn't allocate for each segment it queues
+using SegmentQueue = std::queue<TCPSegment, RingBuffer<TCPSegment>>;
+
 #endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_HH
@@ -0,0 +1,241 @@
+#include "tcp_sharded_engine.hh"
+
+#include "ipv4_header.hh"
+#include "parser.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+ShardedTCPEngine::ShardedTCPEngine(const size_t shards, Handler handler, const size_t queue_capacity)
+    : _handler(move(handler)) {
+    if (shards == 0 or shards > INDIRECTION_ENTRIES) {
+        throw runtime_error("ShardedTCPEngine: shards must be between 1 and " + to_string(INDIRECTION_ENTRIES));
+    }
+
+    // spread the hash values over the shards round-robin, as a NIC's default table does
+    for (size_t i = 0; i < INDIRECTION_ENTRIES; i++) {
+        _indirection[i] = static_cast<uint8_t>(i % shards);
+    }
+
+    for (size_t i = 0; i < shards; i++) {
+        _shards.push_back(make_unique<Shard>(queue_capacity));
+    }
+    // only once every shard exists, since the workers may run the handler straight away
+    for (size_t i = 0; i < shards; i++) {
+        _shards[i]->worker = thread(&ShardedTCPEngine::_work, this, ref(*_shards[i]), i);
+    }
+}
+
+ShardedTCPEngine::~ShardedTCPEngine() {
+    try {
+        stop();
+    } catch (const exception &e) {
+        cerr << "Exception destructing ShardedTCPEngine: " << e.what() << endl;
+    }
+}
+
+void ShardedTCPEngine::stop() {
+    _stop.store(true, memory_order_release);
+    for (const auto &shard : _shards) {
+        shard->wakeup.notify();
+    }
+    for (const auto &shard : _shards) {
+        if (shard->worker.joinable()) {
+            shard->worker.join();
+        }
+    }
+}
+
+//! \details The key is slid along the input one bit at a time, and the 32 bits of key at each
+//! set bit of input are XORed into the hash. The input is the source address, destination
+//! address, source port and destination port, in network byte order.
+uint32_t ShardedTCPEngine::toeplitz_hash(const TCPFourTuple &tuple) {
+    const array<uint8_t, 12> input = {static_cast<uint8_t>(tuple.remote_address >> 24),
+                                      static_cast<uint8_t>(tuple.remote_address >> 16),
+                                      static_cast<uint8_t>(tuple.remote_address >> 8),
+                                      static_cast<uint8_t>(tuple.remote_address),
+                                      static_cast<uint8_t>(tuple.local_address >> 24),
+                                      static_cast<uint8_t>(tuple.local_address >> 16),
+                                      static_cast<uint8_t>(tuple.local_address >> 8),
+                                      static_cast<uint8_t>(tuple.local_address),
+                                      static_cast<uint8_t>(tuple.remote_port >> 8),
+                                      static_cast<uint8_t>(tuple.remote_port),
+                                      static_cast<uint8_t>(tuple.local_port >> 8),
+                                      static_cast<uint8_t>(tuple.local_port)};
+
+    // the 64 bits of key from the current byte on: the top 32 are the window for its first bit
+    const auto key_bits = [](const size_t byte) {
+        uint64_t bits = 0;
+        for (size_t i = byte; i < byte + 8; i++) {
+            bits = (bits << 8) | DEFAULT_RSS_KEY[i];
+        }
+        return bits;
+    };
+
+    uint32_t hash = 0;
+    for (size_t byte = 0; byte < input.size(); byte++) {
+        const uint64_t key = key_bits(byte);
+        for (unsigned bit = 0; bit < 8; bit++) {
+            if (input[byte] & (0x80 >> bit)) {
+                hash ^= static_cast<uint32_t>(key >> (32 - bit));
+            }
+        }
+    }
+    return hash;
+}
+
+//! \details Each turn round the loop, a worker runs the tasks posted to it, feeds its engine a
+//! batch of datagrams, moves the engine's clock on (so due timers fire), calls the handler,
+//! and passes on what the engine sent. After a turn with nothing to do, it sleeps until a
+//! producer wakes it or its engine's next deadline comes.
+void ShardedTCPEngine::_work(Shard &shard, const size_t index) {
+    try {
+        TCPEngine &engine = shard.engine;
+        Task task;
+        InternetDatagram dgram;
+        while (not _stop.load(memory_order_acquire)) {
+            bool busy = false;
+            while (shard.tasks.pop(task)) {
+                task(engine);
+                busy = true;
+            }
+
+            for (size_t i = 0; i < BATCH and shard.inbound.pop(dgram); i++) {
+                engine.datagram_received(dgram);
+                busy = true;
+            }
+
+            engine.advance(timestamp_ms());
+            if (_handler) {
+                _handler(index, engine);
+            }
+
+            // what doesn't fit waits in the engine's queue for the next turn
+            auto &out = engine.datagrams_out();
+            bool sent = false;
+            while (not out.empty() and shard.outbound.push(move(out.front()))) {
+                out.pop();
+                sent = true;
+            }
+            if (sent) {
+                _egress.notify();
+                continue;
+            }
+            if (busy) {
+                continue;
+            }
+
+            // look once more after preparing to sleep, so nothing pushed since is missed
+            shard.wakeup.prepare();
+            if (not shard.tasks.empty() or not shard.inbound.empty() or _stop.load(memory_order_acquire)) {
+                continue;
+            }
+            int timeout = -1;
+            if (not out.empty()) {
+                timeout = BACKLOG_WAIT_MS;
+            } else if (const auto deadline = engine.next_deadline()) {
+                const uint64_t now = timestamp_ms();
+                timeout = static_cast<int>(min<uint64_t>(*deadline > now ? *deadline - now : 0, INT32_MAX));
+            }
+            shard.wakeup.wait(timeout);
+        }
+    } catch (const exception &e) {
+        cerr << "Exception in ShardedTCPEngine shard " << index << ": " << e.what() << endl;
+    }
+}
+
+bool ShardedTCPEngine::datagram_received(InternetDatagram &&dgram) {
+    // read the ports without parsing the segment, as a NIC does; the shard parses it
+    const auto &buffers = dgram.payload().buffers();
+    if (dgram.header().proto != IPv4Header::PROTO_TCP or dgram.payload().size() < 4) {
+        _dropped++;
+        return false;
+    }
+    const string ports = buffers.front().size() >= 4 ? string(buffers.front().str().substr(0, 4))
+                                                     : dgram.payload().concatenate().substr(0, 4);
+    const auto port = [&](const size_t i) {
+        return static_cast<uint16_t>((static_cast<uint8_t>(ports[i]) << 8) | static_cast<uint8_t>(ports[i + 1]));
+    };
+
+    const TCPFourTuple tuple{dgram.header().dst, port(2), dgram.header().src, port(0)};
+    Shard &shard = *_shards[shard_of(tuple)];
+    if (not shard.inbound.push(move(dgram))) {
+        _dropped++;
+        return false;
+    }
+    shard.wakeup.notify();
+    return true;
+}
+
+size_t ShardedTCPEngine::datagrams_out(vector<InternetDatagram> &out) {
+    const size_t before = out.size();
+    InternetDatagram dgram;
+    for (const auto &shard : _shards) {
+        while (shard->outbound.pop(dgram)) {
+            out.push_back(move(dgram));
+        }
+    }
+    return out.size() - before;
+}
+
+bool ShardedTCPEngine::post(const size_t shard, Task &&task) {
+    Shard &target = *_shards.at(shard);
+    if (not target.tasks.push(move(task))) {
+        return false;
+    }
+    target.wakeup.notify();
+    return true;
+}
+
+void ShardedTCPEngine::listen(const TCPConfig &config, const Address &local, const size_t backlog) {
+    for (size_t i = 0; i < _shards.size(); i++) {
+        while (not post(i, [=](TCPEngine &engine) { engine.listen(config, local, backlog); })) {
+            this_thread::yield();
+        }
+    }
+}
+
+void ShardedTCPEngine::run(FileDescriptor &tun, EventLoop &eventloop, const function<bool()> &condition) {
+    vector<InternetDatagram> outbound;
+
+    eventloop.add_rule(tun, Direction::In, [&] {
+        InternetDatagram dgram;
+        if (dgram.parse(tun.read()) == ParseResult::NoError) {
+            datagram_received(move(dgram));
+        } else {
+            _dropped++;
+        }
+    });
+
+    eventloop.add_rule(
+        tun,
+        Direction::Out,
+        [&] {
+            for (const InternetDatagram &dgram : outbound) {
+                tun.write(dgram.serialize());
+            }
+            outbound.clear();
+        },
+        [&] { return not outbound.empty(); });
+
+    // the workers wake this thread when they have sent something
+    eventloop.add_rule(_egress.fd(), Direction::In, [&] {
+        _egress.fd().read();
+        datagrams_out(outbound);
+    });
+
+    while (condition()) {
+        _egress.prepare();
+        datagrams_out(outbound);
+        if (eventloop.wait_next_event(MAX_WAIT_MS) == EventLoop::Result::Exit) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,175 @@
+#ifndef SPONGE_LIBSPONGE_TCP_SHARDED_ENGINE_HH
+#define SPONGE_LIBSPONGE_TCP_SHARDED_ENGINE_HH
+
+#include "address.hh"
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "ipv4_datagram.hh"
+#include "spsc_queue.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+#include "wakeup.hh"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//! \brief TCPEngines on a pool of worker threads, each owning the connections whose four-tuples hash to it
+//!
+//! This is the receive-side scaling (RSS) a multi-queue NIC does: each datagram's four-tuple is
+//! hashed with the Toeplitz function, and the hash picks a shard through an indirection table, so
+//! every segment of a connection goes to the same shard, and the shards share nothing. A shard is a
+//! TCPEngine and the thread that drives it; the connections it owns are only ever touched on that
+//! thread, so neither TCPEngine nor TCPConnection needs to know about threads.
+//!
+//! Three kinds of thread talk to the shards, each through single-producer, single-consumer queues
+//! of its own, so no locks are taken:
+//! - one ingress thread calls datagram_received(), which hashes each datagram to its shard;
+//! - one egress thread calls datagrams_out(), to collect what the shards have sent;
+//! - one control thread calls post() and listen(), to run tasks on a shard's engine.
+//!
+//! (run() plays all three parts from one thread.) Applications run on the workers too: the handler
+//! given to the constructor is called on each shard's thread every time round its loop, to accept,
+//! read, and write the shard's connections.
+//!
+//! A worker with nothing to do sleeps until a datagram or task arrives for it, or its engine's
+//! next deadline; an application that wants its handler called at other times can post() a task
+//! that does nothing. Likewise the workers wake the egress thread when they have sent something.
+class ShardedTCPEngine {
+  public:
+    //! Work to run on a shard's thread, with its engine
+    using Task = std::function<void(TCPEngine &engine)>;
+
+    //! Called on each shard's thread every time round its loop, with the shard's index and engine
+    using Handler = std::function<void(const size_t shard, TCPEngine &engine)>;
+
+    //! Slots in each of a shard's queues, unless the constructor says otherwise
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 4096;
+
+    //! Entries in the indirection table, as on common NICs; also the most shards there can be
+    static constexpr size_t INDIRECTION_ENTRIES = 128;
+
+    //! Most datagrams a worker takes from its queue before it attends to timers and the handler
+    static constexpr size_t BATCH = 64;
+
+    //! Longest run() sleeps with nothing to do, so it notices `condition`
+    static constexpr int MAX_WAIT_MS = static_cast<int>(TCPEngine::MAX_WAIT_MS);
+
+    //! Longest a worker sleeps when its engine has sent more than its outbound queue will take
+    static constexpr int BACKLOG_WAIT_MS = 1;
+
+    //! The Toeplitz key from Microsoft's RSS specification, which most NICs use by default
+    static constexpr std::array<uint8_t, 40> DEFAULT_RSS_KEY = {
+        0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3,
+        0x8f, 0xb0, 0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3,
+        0x80, 0x30, 0xf2, 0x0c, 0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa};
+
+  private:
+    struct Shard {
+        TCPEngine engine{};
+        SPSCQueue<InternetDatagram> inbound;   // from the ingress thread
+        SPSCQueue<Task> tasks;                 // from the control thread
+        SPSCQueue<InternetDatagram> outbound;  // to the egress thread
+        Wakeup wakeup{};                       // for the worker, when it sleeps
+        std::thread worker{};
+
+        explicit Shard(const size_t capacity) : inbound(capacity), tasks(capacity), outbound(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> _shards{};
+
+    //! Shard for each value of the hash's low bits
+    std::array<uint8_t, INDIRECTION_ENTRIES> _indirection{};
+
+    Handler _handler;
+
+    //! Tells the workers to finish
+    std::atomic<bool> _stop{false};
+
+    //! For the egress thread, when it sleeps
+    Wakeup _egress{};
+
+    //! Datagrams the ingress thread couldn't hash, or whose shard's queue was full
+    uint64_t _dropped{0};
+
+    //! A shard's thread
+    void _work(Shard &shard, const size_t index);
+
+  public:
+    //! \brief Start `shards` workers
+    //! \param[in] shards how many workers, from 1 to INDIRECTION_ENTRIES
+    //! \param[in] handler called on each worker, every time round its loop
+    //! \param[in] queue_capacity slots in each of each shard's queues
+    explicit ShardedTCPEngine(const size_t shards,
+                              Handler handler = {},
+                              const size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+
+    //! \brief Stops the workers
+    ~ShardedTCPEngine();
+
+    ShardedTCPEngine(const ShardedTCPEngine &other) = delete;
+    ShardedTCPEngine &operator=(const ShardedTCPEngine &other) = delete;
+
+    //! \brief The Toeplitz hash of a four-tuple, as a NIC computes it for a datagram arriving on it
+    //! (source address and port the remote's, destination ours)
+    static uint32_t toeplitz_hash(const TCPFourTuple &tuple);
+
+    //! \brief The shard that owns a connection
+    size_t shard_of(const TCPFourTuple &tuple) const {
+        return _indirection[toeplitz_hash(tuple) & (INDIRECTION_ENTRIES - 1)];
+    }
+
+    //! \brief The number of shards
+    size_t shards() const { return _shards.size(); }
+
+    //! \brief Stop the workers, once they have finished their current turn round the loop (idempotent)
+    //! \note Connections that are still open stay as they are; the engines are freed with the ShardedTCPEngine.
+    void stop();
+
+    //! \name Ingress thread
+    //!@{
+
+    //! \brief Hand a datagram to the shard its four-tuple hashes to
+    //! \returns false if it was dropped, because it wasn't TCP or the shard's queue was full
+    bool datagram_received(InternetDatagram &&dgram);
+
+    //! \brief Datagrams dropped by datagram_received()
+    uint64_t dropped() const { return _dropped; }
+    //!@}
+
+    //! \name Egress thread
+    //!@{
+
+    //! \brief Woken (and its fd made readable) when the workers have sent datagrams: an egress
+    //! thread that sleeps calls Wakeup::prepare() before its last call to datagrams_out()
+    Wakeup &egress_wakeup() { return _egress; }
+
+    //! \brief Collect the datagrams the shards have sent, appending them to `out`
+    //! \returns how many were appended
+    size_t datagrams_out(std::vector<InternetDatagram> &out);
+    //!@}
+
+    //! \name Control thread
+    //!@{
+
+    //! \brief Run `task` on a shard's thread, with its engine
+    //! \returns false if the shard's task queue was full, so the task wasn't queued
+    bool post(const size_t shard, Task &&task);
+
+    //! \brief Have every shard listen on `local`, with a backlog of `backlog` each
+    //! \details Each shard accepts the connections that hash to it; the handler finds them with
+    //! TCPEngine::accept() on its shard's engine. Waits while a shard's task queue is full.
+    void listen(const TCPConfig &config, const Address &local, const size_t backlog = TCPEngine::DEFAULT_BACKLOG);
+    //!@}
+
+    //! \brief Be the ingress, egress, and control threads for `tun`, while `condition` holds
+    //! \details Adds two rules to `eventloop` and then runs it. Call it once for each `eventloop`.
+    void run(FileDescriptor &tun, EventLoop &eventloop, const std::function<bool()> &condition);
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_SHARDED_ENGINE_HH
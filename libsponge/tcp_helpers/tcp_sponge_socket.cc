@@ -18,23 +18,53 @@
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
+//! Longest the TCP thread sleeps when no timer is due sooner, so it notices _abort
+static constexpr uint64_t TCP_MAX_WAIT_MS = 100;
+
+//! Keys of the timers in TCPSpongeSocket::_timers
+static constexpr TimerWheel::Key CONNECTION_TIMER = 0;
+static constexpr TimerWheel::Key ADAPTER_TIMER = 1;
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_schedule(const TimerWheel::Key key, const optional<size_t> ms, const uint64_t base_time) {
+    if (ms) {
+        _timers.schedule(key, base_time + *ms);
+    } else {
+        _timers.cancel(key);
+    }
+}
 
 //! \param[in] condition is a function returning true if loop should continue
+//! \details Instead of waking every few milliseconds to tick the TCPConnection and the adapter, the
+//! loop sleeps until an event arrives or the earlier of their next deadlines, so an idle
+//! connection costs nothing.
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // the events and ticks since the last pass may have moved either deadline
+        _schedule(CONNECTION_TIMER, _tcp->time_until_deadline(), base_time);
+        _schedule(ADAPTER_TIMER, _datagram_adapter.time_until_deadline(), base_time);
+        uint64_t wait = TCP_MAX_WAIT_MS;
+        if (const auto deadline = _timers.next_deadline()) {
+            const auto now = timestamp_ms();
+            wait = min(wait, *deadline > now ? *deadline - now : 0);
+        }
+
+        auto ret = _eventloop.wait_next_event(static_cast<int>(wait));
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
 
+        // both are ticked whenever the loop wakes, not only when their timers expire, so their
+        // clocks keep up with the events they handle
         if (_tcp.value().active()) {
             const auto next_time = timestamp_ms();
             _tcp.value().tick(next_time - base_time);
             _datagram_adapter.tick(next_time - base_time);
             base_time = next_time;
+            _timers.advance(next_time, _expired);
+            _expired.clear();
         }
     }
 }
@@ -96,12 +126,8 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
-            const auto len = data.size();
-            const auto amount_written = _tcp->write(move(data));
-            if (amount_written != len) {
-                throw runtime_error("TCPConnection::write() accepted less than advertised length");
-            }
+            // read(2) lands the bytes directly in the outbound stream's free space
+            _tcp->write_from(_thread_data);
 
             if (_thread_data.eof()) {
                 _tcp->end_input_stream();
@@ -128,9 +154,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // Write from the inbound_stream into
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
+            // The bytes go to writev() straight out of the stream's storage.
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto bytes_written = _thread_data.write(inbound.peek_views(amount_to_write), false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
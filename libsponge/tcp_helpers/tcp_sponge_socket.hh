@@ -8,6 +8,7 @@
 #include "network_interface.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
+#include "timer_wheel.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
@@ -37,6 +38,15 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
+    //! Deadlines of the TCPConnection's and the adapter's timers, so the loop sleeps until one is due
+    TimerWheel _timers{};
+
+    //! Keys of the timers that expired as the loop woke up
+    std::vector<TimerWheel::Key> _expired{};
+
+    //! Set `key`'s deadline `ms` after `base_time` (the last tick), or cancel it if `ms` is empty
+    void _schedule(const TimerWheel::Key key, const std::optional<size_t> ms, const uint64_t base_time);
+
     //! Process events while specified condition is true
     void _tcp_loop(const std::function<bool()> &condition);
 
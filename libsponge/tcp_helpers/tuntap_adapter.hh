@@ -66,6 +66,9 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! Milliseconds until tick() next has something to do (the NetworkInterface's ARP cache), or empty if never
+    std::optional<size_t> time_until_deadline() const { return _interface.time_until_deadline(); }
+
     //! Access the underlying raw Ethernet connection
     operator TapFD &() { return _tap; }
 
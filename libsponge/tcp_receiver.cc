@@ -1,11 +1,23 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+#include <cstdint>
+
 using namespace std;
 
-void TCPReceiver::segment_received(const TCPSegment &seg) {
+bool TCPReceiver::segment_received(const TCPSegment &seg) {
+    // PAWS (RFC 7323 section 5.3): a segment whose TSval is older than TS.Recent was sent before
+    // one we already accepted, so it is an old duplicate, even if its seqno has wrapped around
+    // into the window; drop it (a RST is exempt)
+    const optional<TCPTimestamps> &ts = seg.header().options.timestamps;
+    if (timestamps && ts && tsRecent && !seg.header().rst && static_cast<int32_t>(ts->value - *tsRecent) < 0) {
+        pawsDropped++;
+        return false;
+    }
+
     // if FIN has been received and everything has been reassembled, return
     if (FIN_RECV && _reassembler.empty())
-        return;
+        return true;
 
     // if we receive SYN, set SYN_RECV to true
     // and set isn to the seqno of SYN
@@ -14,6 +26,17 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         isn = seg.header().seqno;
     }
 
+    if (seg.payload().size() > 0) {
+        idleTime = 0;
+    }
+
+    // note the TSval to echo from a segment that reaches the last ackno we sent, not the current
+    // one, so that with delayed ACKs the echo measures the time since the oldest data an ACK
+    // covers was sent (RFC 7323 section 4.3)
+    if (timestamps && ts && (seg.header().syn || (lastAckSent && seg.header().seqno - *lastAckSent <= 0))) {
+        tsRecent = ts->value;
+    }
+
     // if we have received SYN, then push the payload of the segment to the reassembler
     if (SYN_RECV) {
         // if we receive FIN, set FIN_RECV to true
@@ -21,7 +44,6 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
             FIN_RECV = true;
         }
 
-        string toPush = seg.payload().copy();
         uint64_t index;
 
         // if the segment includes SYN, then the index of the first byte of the payload is
@@ -32,11 +54,15 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
             index = unwrap(seg.header().seqno, isn, _reassembler.stream_out().bytes_written()) - 1;
         }
 
-        // push substring to the reassembler
-        _reassembler.push_substring(toPush, index, seg.header().fin);
+        if (index > _reassembler.stream_out().bytes_written()) {
+            lastOutOfOrder = index;
+        }
+
+        // push the payload to the reassembler (it shares the payload's memory rather than copying it)
+        _reassembler.push_substring(seg.payload(), index, seg.header().fin);
     }
 
-    return;
+    return true;
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -56,4 +82,85 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
     return wrap(n, isn);
 }
 
-size_t TCPReceiver::window_size() const { return _reassembler.stream_out().remaining_capacity(); }
+size_t TCPReceiver::sack_blocks(array<TCPSackBlock, TCPOptions::MAX_SACK_BLOCKS> &blocks,
+                                const size_t max_blocks) const {
+    if (!SYN_RECV or max_blocks == 0 or _reassembler.empty()) {
+        return 0;
+    }
+
+    // stream index i has absolute seqno i + 1 (the SYN comes first)
+    const auto to_block = [&](const pair<uint64_t, uint64_t> &range) {
+        return TCPSackBlock{wrap(range.first + 1, isn), wrap(range.second + 1, isn)};
+    };
+
+    const auto ranges = _reassembler.unassembled_ranges(SIZE_MAX);
+    const auto latest = find_if(ranges.begin(), ranges.end(), [&](const pair<uint64_t, uint64_t> &range) {
+        return range.first <= lastOutOfOrder and lastOutOfOrder < range.second;
+    });
+
+    size_t count = 0;
+    if (latest != ranges.end()) {
+        blocks[count++] = to_block(*latest);
+    }
+    for (auto it = ranges.begin(); it != ranges.end() and count < min(max_blocks, blocks.size()); ++it) {
+        if (it != latest) {
+            blocks[count++] = to_block(*it);
+        }
+    }
+    return count;
+}
+
+void TCPReceiver::ack_sent(const WrappingInt32 ackno_sent, const size_t window) {
+    lastAckSent = ackno_sent;
+    if (SYN_RECV) {
+        // stream index i has absolute seqno i + 1 (the SYN comes first)
+        const uint64_t start = unwrap(ackno_sent, isn, _reassembler.stream_out().bytes_written()) - 1;
+        advertisedEdge = max(advertisedEdge, start + window);
+    }
+}
+
+size_t TCPReceiver::promised_room() const {
+    const uint64_t read = _reassembler.stream_out().bytes_read();
+    return advertisedEdge > read ? advertisedEdge - read : 0;
+}
+
+void TCPReceiver::tick(const size_t ms_since_last_tick, const optional<uint64_t> rtt) {
+    if (maxCapacity <= initialCapacity) {
+        return;
+    }
+    sinceMeasured += ms_since_last_tick;
+    idleTime += ms_since_last_tick;
+
+    // the bytes the reader took in one RTT (scaled, since ticks needn't land on the interval);
+    // grow to twice that if it was more than half the capacity
+    const ByteStream &stream = _reassembler.stream_out();
+    const uint64_t interval = max<uint64_t>(rtt.value_or(AUTOTUNE_INTERVAL_DFLT), 1);
+    if (sinceMeasured >= interval) {
+        const uint64_t perRtt = (stream.bytes_read() - readWhenMeasured) * interval / sinceMeasured;
+        if (2 * perRtt > _capacity && _capacity < maxCapacity) {
+            _capacity = min<uint64_t>(2 * perRtt, maxCapacity);
+            _reassembler.set_capacity(max(_capacity, promised_room()));
+        }
+        sinceMeasured = 0;
+        readWhenMeasured = stream.bytes_read();
+    }
+
+    // an idle connection gives the memory back, though only once the peer can no longer send
+    // beyond the smaller window: until then the buffers keep room up to the edge it last saw
+    if (idleTime >= AUTOTUNE_IDLE && _capacity > initialCapacity && stream.buffer_empty() && _reassembler.empty()) {
+        _capacity = initialCapacity;
+    }
+    if (_reassembler.capacity() > _capacity && promised_room() <= _capacity) {
+        _reassembler.set_capacity(_capacity);
+    }
+}
+
+//! \details The capacity, less what the stream holds; after the capacity shrinks, though, never
+//! less than what the window last advertised still allows, so its right edge doesn't move left.
+size_t TCPReceiver::window_size() const {
+    const ByteStream &stream = _reassembler.stream_out();
+    const size_t window = _capacity > stream.buffer_size() ? _capacity - stream.buffer_size() : 0;
+    const uint64_t written = stream.bytes_written();
+    const size_t promised = advertisedEdge > written ? advertisedEdge - written : 0;
+    return min(max(window, promised), stream.remaining_capacity());
+}
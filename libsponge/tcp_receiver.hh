@@ -6,6 +6,7 @@
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <array>
 #include <optional>
 
 //! \brief The "receiver" part of a TCP implementation.
@@ -14,7 +15,8 @@
 //! the acknowledgment number and window size to advertise back to the
 //! remote TCPSender.
 class TCPReceiver {
-    //! Our data structure for re-assembling bytes.
+    //! Our data structure for re-assembling bytes. Its output stream is Chunked, so each
+    //! payload reaches the reader as a slice of the segment it arrived in, without a copy.
     StreamReassembler _reassembler;
 
     //! The maximum number of bytes we'll store.
@@ -28,13 +30,82 @@ class TCPReceiver {
     // initial sequence number of the stream
     WrappingInt32 isn;
 
+    // stream index of the first byte of the most recent segment that arrived out of order,
+    // so the SACK block holding it can be reported first
+    uint64_t lastOutOfOrder;
+
+    // timestamps (RFC 7323): whether they are in use, TS.Recent, the TSval to echo (taken from
+    // the latest segment that reached the last ackno we sent), once one has arrived, and that
+    // ackno (Last.ACK.sent)
+    bool timestamps;
+    std::optional<uint32_t> tsRecent;
+    std::optional<WrappingInt32> lastAckSent;
+
+    // the number of segments dropped as old duplicates by PAWS
+    uint64_t pawsDropped;
+
+    // receive buffer auto-tuning: the capacity to fall back to when idle, and the largest it may
+    // grow to (no more than initialCapacity if auto-tuning is off)
+    size_t initialCapacity;
+    size_t maxCapacity;
+
+    // milliseconds since the reader's pace was last measured, and bytes it had read by then
+    size_t sinceMeasured;
+    uint64_t readWhenMeasured;
+
+    // milliseconds since a segment last brought data
+    size_t idleTime;
+
+    // stream index just past the last byte the peer may send, by the ACKs we have sent: a
+    // capacity that shrinks leaves the buffers (and the window) reaching this far until the
+    // reader catches up, so the right edge of the window never moves left (RFC 7323 section 2.4)
+    uint64_t advertisedEdge;
+
+    // the bytes of buffer the peer may still fill, by the last window we advertised
+    size_t promised_room() const;
+
   public:
+    //! Measurement interval for auto-tuning when no RTT estimate is available, in milliseconds
+    static constexpr size_t AUTOTUNE_INTERVAL_DFLT = 100;
+
+    //! Milliseconds without data after which an auto-tuned receiver shrinks back to its initial capacity
+    static constexpr size_t AUTOTUNE_IDLE = 1000;
+
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity)
-        : _reassembler(capacity), _capacity(capacity), SYN_RECV(false), FIN_RECV(false), isn(0) {}
+    //! \param backend where the reassembler keeps out-of-order bytes
+    //! \param max_capacity with a value above `capacity`, the most the capacity may grow to as the
+    //!                     reader keeps up (receive buffer auto-tuning, see tick())
+    TCPReceiver(const size_t capacity,
+                const StreamReassembler::Backend backend = StreamReassembler::Backend::IntervalMap,
+                const size_t max_capacity = 0)
+        : _reassembler(capacity, backend, ByteStream::Storage::Chunked)
+        , _capacity(capacity)
+        , SYN_RECV(false)
+        , FIN_RECV(false)
+        , isn(0)
+        , lastOutOfOrder(0)
+        , timestamps(false)
+        , tsRecent()
+        , lastAckSent()
+        , pawsDropped(0)
+        , initialCapacity(capacity)
+        , maxCapacity(max_capacity)
+        , sinceMeasured(0)
+        , readWhenMeasured(0)
+        , idleTime(0)
+        , advertisedEdge(0) {}
+
+    //! \brief Use the timestamps option (RFC 7323) from now on: note the TSval to echo, and drop
+    //! segments whose TSval is older than that one (PAWS, Protection Against Wrapped Sequences)
+    void use_timestamps() { timestamps = true; }
+
+    //! \brief Note an ACK that was actually sent: its ackno (Last.ACK.sent) decides the segments
+    //! whose TSval is echoed, and with its window, the right edge a shrinking capacity must keep
+    //! \param window the window the ACK advertised, in bytes (after any scaling)
+    void ack_sent(const WrappingInt32 ackno_sent, const size_t window);
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -57,13 +128,42 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief SACK blocks (RFC 2018) describing data held beyond the ackno
+    //!
+    //! The block holding the most recently received out-of-order segment comes first,
+    //! followed by the lowest other blocks, so over successive ACKs every block is reported.
+    //! \param[out] blocks filled in with up to `max_blocks` blocks
+    //! \returns the number of blocks written
+    size_t sack_blocks(std::array<TCPSackBlock, TCPOptions::MAX_SACK_BLOCKS> &blocks,
+                       const size_t max_blocks = TCPOptions::MAX_SACK_BLOCKS) const;
+
+    //! \brief The TSval to echo in TSecr (TS.Recent), or empty if none has arrived
+    std::optional<uint32_t> ts_recent() const { return tsRecent; }
     //!@}
 
+    //! \brief number of segments dropped as old duplicates by PAWS
+    uint64_t paws_dropped() const { return pawsDropped; }
+
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
     //! \brief handle an inbound segment
-    void segment_received(const TCPSegment &seg);
+    //! \returns false if it was dropped as an old duplicate by PAWS, so nothing in it (its ackno
+    //! and window included) should be believed
+    bool segment_received(const TCPSegment &seg);
+
+    //! \brief Notifies the receiver of the passage of time
+    //! \details With auto-tuning, once per `rtt` this measures how many bytes the reader took. If that
+    //! is more than half the capacity, the window rather than the reader is what limits the sender,
+    //! so the capacity grows to twice as much (up to the maximum), letting the sender's window keep
+    //! doubling. After AUTOTUNE_IDLE ms without data, with nothing buffered, it shrinks back,
+    //! though the window keeps reaching the right edge already advertised until the peer is there.
+    //! \param rtt the connection's smoothed RTT, if it has one (otherwise AUTOTUNE_INTERVAL_DFLT is used)
+    void tick(const size_t ms_since_last_tick, const std::optional<uint64_t> rtt = {});
+
+    //! \brief The number of bytes the receiver can store at the moment
+    size_t capacity() const { return _capacity; }
 
     //! \name "Output" interface for the reader
     //!@{
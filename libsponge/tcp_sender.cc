@@ -2,15 +2,21 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
 #include <iostream>
 #include <random>
+#include <vector>
 
 using namespace std;
 
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] max_payload_size the largest payload to put in one segment
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const size_t max_payload_size)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
     , rto{retx_timeout}
@@ -21,45 +27,102 @@ TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const s
     , outstanding(0)
     , t()
     , consecutive(0)
-    , windowSize(1) {}
+    , windowSize(1)
+    , maxPayload(max_payload_size)
+    , adaptiveRto(false)
+    , minRto(TCPConfig::MIN_RTO_DFLT)
+    , maxRto(0)
+    , now(0)
+    , haveRtt(false)
+    , srttScaled(0)
+    , rttvarScaled(0)
+    , sacked()
+    , highRetransmitted(0)
+    , cc()
+    , recoveryPoint()
+    , delivered(0)
+    , deliveredAt(0)
+    , firstSentAt(0)
+    , appLimitedUntil(0)
+    , pacingCredit(CongestionControl::INITIAL_WINDOW * max_payload_size)
+    , fastRetransmit(false)
+    , dupAcks(0)
+    , fastRecovery(false)
+    , recoveryInflation(0)
+    , nagle(false) {}
+
+//! \param[in] config the connection's settings (capacity, timeouts, ISN, MSS, RTO estimation,
+//! congestion control, fast retransmit, and Nagle's algorithm)
+TCPSender::TCPSender(const TCPConfig &config)
+    : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn, config.mss) {
+    adaptiveRto = config.adaptive_rto;
+    minRto = config.min_rto;
+    maxRto = config.max_rto > 0 ? config.max_rto : (adaptiveRto ? TCPConfig::MAX_RTO_DFLT : 0);
+    cc = CongestionControl::make(config.congestion_control, config.mss);
+    fastRetransmit = config.fast_retransmit;
+    nagle = config.nagle;
+}
 
-// the number of bytes_in_flight is equal to the number of bytes stored in our
-// list of outstanding segments
-uint64_t TCPSender::bytes_in_flight() const { return outstanding; }
+//! \param[in] max_payload_size the largest payload to put in one segment from now on
+void TCPSender::set_max_payload_size(const size_t max_payload_size) {
+    maxPayload = max_payload_size;
+    if (cc) {
+        cc->set_mss(max_payload_size);
+    }
+}
+
+optional<uint64_t> TCPSender::smoothed_rtt() const {
+    if (!haveRtt) {
+        return {};
+    }
+    return srttScaled / 8;
+}
 
 /*
- * Function Name: addToOutstanding
- * Args: TCPSegment seg
- * Description: This function takes in a TCPSegment seg and adds it to the sorted list of
- * outstanding segments that have been sent to the TCP Receiver but not yet
- * acknowledged.
+ * Function Name: rtt_sample
+ * Args: const uint64_t rtt
+ * Description: This function takes in a round-trip time measurement and updates SRTT
+ * and RTTVAR as in RFC 6298 section 2: the first sample sets SRTT = R and RTTVAR = R/2,
+ * and later ones move RTTVAR a quarter of the way to |SRTT - R| and SRTT an eighth of
+ * the way to R. With adaptive RTO, it then sets the RTO from the new estimate.
  */
-void TCPSender::addToOutstanding(TCPSegment seg) {
-    // keep track of how many bytes are outstanding or "in flight"
-    outstanding += seg.length_in_sequence_space();
-
-    // go through each element of outstanding_segments
-    // insert seg into list in sorted fashion
-    for (auto it = outstanding_segments.begin(); it != outstanding_segments.end(); it++) {
-        TCPSegment next = *it;
-        if (seg.header().seqno.raw_value() < next.header().seqno.raw_value()) {
-            outstanding_segments.insert(it, seg);
-            return;
-        }
+void TCPSender::rtt_sample(const uint64_t rtt) {
+    if (!haveRtt) {
+        haveRtt = true;
+        srttScaled = rtt * 8;
+        rttvarScaled = rtt * 2;
+    } else {
+        const uint64_t srtt = srttScaled / 8;
+        const uint64_t delta = srtt > rtt ? srtt - rtt : rtt - srtt;
+        rttvarScaled = rttvarScaled - rttvarScaled / 4 + delta;
+        srttScaled = srttScaled - srttScaled / 8 + rtt;
     }
 
-    // if outstanding_segments is empty, or seg's seqno is larger than all outstanding segments
-    // push seg to back of list
-    outstanding_segments.push_back(seg);
+    if (adaptiveRto) {
+        rto = estimated_rto();
+    }
 }
 
+//! \returns SRTT + max(1 ms, 4 * RTTVAR), raised to minRto and then lowered to maxRto (so if a
+//! configuration crosses the bounds, maxRto wins)
+unsigned int TCPSender::estimated_rto() const {
+    const uint64_t computed = srttScaled / 8 + max(uint64_t{1}, rttvarScaled);
+    return static_cast<unsigned int>(min(max(computed, uint64_t{minRto}), uint64_t{maxRto}));
+}
+
+// the number of bytes_in_flight is equal to the number of bytes stored in our
+// queue of outstanding segments
+uint64_t TCPSender::bytes_in_flight() const { return outstanding; }
+
 /*
  * Function Name: construct_TCPSegment
- * Args: int length
+ * Args: int length, Buffer &batch
  * Description: This function takes in the desired length of a TCP Segment
- * and constructs a TCP Segment with the next sequence number needed.
+ * and constructs a TCP Segment with the next sequence number needed. Its payload
+ * is sliced off the front of batch (bytes peeked from the front of the stream),
+ * so it shares batch's storage; batch is only refilled if it runs short.
  */
-TCPSegment TCPSender::construct_TCPSegment(int length) {
+TCPSegment TCPSender::construct_TCPSegment(int length, Buffer &batch) {
     // initialize a TCP segment
     TCPSegment seg;
 
@@ -72,11 +135,17 @@ TCPSegment TCPSender::construct_TCPSegment(int length) {
         length--;
     }
 
-    // read up to MAX_PAYLOAD_SIZE bytes from the Byte Stream
-    // set payload of seg to be bytes read
+    // take up to maxPayload bytes from the Byte Stream
+    // set payload of seg to be bytes taken
     if (length > 0 && !_stream.buffer_empty()) {
-        seg.payload() = Buffer(_stream.read(min(static_cast<size_t>(length), TCPConfig::MAX_PAYLOAD_SIZE)));
-        length -= seg.payload().copy().length();
+        const size_t payloadSize = min({static_cast<size_t>(length), maxPayload, _stream.buffer_size()});
+        if (batch.size() < payloadSize) {
+            batch = _stream.peek_buffer(payloadSize);
+        }
+        seg.payload() = batch.slice(0, payloadSize);
+        batch.remove_prefix(payloadSize);
+        _stream.pop_output(payloadSize);
+        length -= payloadSize;
     }
 
     // set EOF Byte Stream has reached EOF
@@ -100,9 +169,9 @@ void TCPSender::fill_window() {
     // if windowSize is equal to 0, act as if we have windowSize of 1
     // push one byte to _segments_out
     if (windowSize == 0) {
-        // construct seg and add to _segments_out and our list of outstanding segments
-        TCPSegment seg = construct_TCPSegment(1);
-        safe_push_segment(seg);
+        // construct seg and add to _segments_out and our queue of outstanding segments
+        Buffer batch;
+        safe_push_segment(construct_TCPSegment(1, batch));
 
         // reset timer if needed
         if (t.expired()) {
@@ -110,24 +179,60 @@ void TCPSender::fill_window() {
         }
 
     } else {
+        // peek at as much of the stream as this call could send, all at once, so the segments'
+        // payloads are slices of one Buffer instead of an allocation each
+        size_t batchSize = r_edge.raw_value() - l_edge.raw_value();
+        if (cc) {
+            const uint64_t cwnd = cc->cwnd() + recoveryInflation;
+            batchSize = min<size_t>(batchSize, max<uint64_t>(cwnd > outstanding ? cwnd - outstanding : 0, maxPayload));
+            if (cc->pacing_rate()) {
+                batchSize = min<size_t>(batchSize, max<int64_t>(pacingCredit, 0) + maxPayload);
+            }
+        }
+        Buffer batch = _stream.peek_buffer(batchSize);
+
         // while we have space in our window, construct TCP segments and send them
         // to the TCP receiver
         while (l_edge != r_edge) {
             size_t spaceLeft = r_edge.raw_value() - l_edge.raw_value();
 
+            // the congestion window (inflated during fast recovery) only lets whole segments go,
+            // unless nothing is in flight, and the pacing rate only lets them go while there is
+            // credit left from tick()
+            if (cc) {
+                const uint64_t cwnd = cc->cwnd() + recoveryInflation;
+                const uint64_t cwndLeft = cwnd > outstanding ? cwnd - outstanding : 0;
+                if (cwndLeft < maxPayload && outstanding > 0) {
+                    return;
+                }
+                if (cc->pacing_rate() && pacingCredit <= 0) {
+                    return;
+                }
+                spaceLeft = min<size_t>(spaceLeft, max<uint64_t>(cwndLeft, maxPayload));
+            }
+
             // return if we have already reached FIN
             if (_next_seqno == stream_in().bytes_written() + 2) {
+                mark_app_limited();
                 return;
             }
-            TCPSegment seg = construct_TCPSegment(min(TCPConfig::MAX_PAYLOAD_SIZE + 2, spaceLeft));
+
+            // with Nagle's algorithm, what is left can't fill a segment, and something is in flight:
+            // wait for its ACK (or more data) instead, unless this is the last of the stream
+            if (nagle && outstanding > 0 && _stream.buffer_size() < maxPayload && !_stream.input_ended()) {
+                mark_app_limited();
+                return;
+            }
+            TCPSegment seg = construct_TCPSegment(min(maxPayload + 2, spaceLeft), batch);
 
             // return if we can only construct an empty segment (payload empty, no SYN, no FIN)
             if (seg.length_in_sequence_space() == 0) {
+                mark_app_limited();
                 return;
             }
 
-            // add segment to outstanding list and push to TCP Reiver
-            safe_push_segment(seg);
+            // add segment to outstanding queue and push to TCP Reiver
+            safe_push_segment(move(seg));
 
             // restart timer if necessary
             if (!t.running()) {
@@ -138,33 +243,58 @@ void TCPSender::fill_window() {
 }
 
 // this function pushes TCP Segments to _segments_out, and, if they occupy length
-// in sequence space, then it adds them to the list of outstanding segments
+// in sequence space, then it moves them onto the back of the outstanding queue
 // and increments _next_seqno and l_edge
 void TCPSender::safe_push_segment(TCPSegment seg) {
     _segments_out.push(seg);
 
     // if the segment has a payload or SYN/FIN, add it to outstanding and increment
     // _next_seqno and l_edge
-    if (seg.length_in_sequence_space() > 0) {
-        addToOutstanding(seg);
+    const size_t length = seg.length_in_sequence_space();
+    if (length > 0) {
+        // remember what the delivery rate sample for this segment will be measured against
+        if (cc) {
+            if (outstanding == 0) {
+                firstSentAt = deliveredAt = now;
+            }
+            if (cc->pacing_rate()) {
+                pacingCredit -= length;
+            }
+        }
+
+        outstanding += length;
+        outstanding_segments.push_back(
+            {move(seg), _next_seqno, now, 0, delivered, deliveredAt, firstSentAt, appLimitedUntil != 0});
 
         // increment _next_seqno and l_edge
-        _next_seqno += seg.length_in_sequence_space();
-        l_edge = l_edge + static_cast<uint32_t>(seg.length_in_sequence_space());
+        _next_seqno += length;
+        l_edge = l_edge + static_cast<uint32_t>(length);
     }
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param window_size The remote receiver's advertised window size (after window scaling)
+//! \param carries_data Whether the segment carrying the ACK occupies sequence space
+//! \param echoed_rtt The RTT measured from the ACK's echoed timestamp, if it carried one
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const uint32_t window_size,
+                             const bool carries_data,
+                             const optional<uint64_t> echoed_rtt) {
+    const uint64_t ackAbs = unwrap(ackno, _isn, _next_seqno);
+
     // if the ackno is greater than next seqno, return
-    if (ackno.raw_value() > wrap(_next_seqno, _isn).raw_value())
+    if (ackAbs > _next_seqno)
         return;
 
-    // if the ackno is smaller than next seqno, return
-    if (ackno.raw_value() + window_size < wrap(_next_seqno, _isn).raw_value())
+    // if the right edge of the window is below next seqno, return
+    if (ackAbs + window_size < _next_seqno)
         return;
 
+    // an ACK that repeats the ackno and window, with nothing else in it, while data is
+    // outstanding is a duplicate (RFC 5681 section 2)
+    const bool duplicate = !carries_data && !outstanding_segments.empty() &&
+                           ackAbs == outstanding_segments.front().seqno && window_size == windowSize;
+
     // set l_edge and r_edge
     l_edge = wrap(_next_seqno, _isn);
     r_edge = ackno + window_size;
@@ -177,36 +307,255 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
         r_edge = r_edge + 1;
     }
 
-    // initialize bool to record whether any new data is removed from our outstanding list
-    bool dataAcked = false;
+    // a loss has been repaired once everything sent before it was detected is acknowledged
+    if (recoveryPoint && ackAbs >= *recoveryPoint) {
+        recoveryPoint.reset();
+    }
+    const uint64_t priorInFlight = outstanding;
+
+    // pop the segments the ackno covers off the front of the outstanding queue, keeping the
+    // newest one, and noting whether any of them was retransmitted
+    optional<OutstandingSegment> newest;
+    bool retransmissionAcked = false;
+    while (!outstanding_segments.empty() && outstanding_segments.front().end() <= ackAbs) {
+        outstanding -= outstanding_segments.front().segment.length_in_sequence_space();
+        retransmissionAcked = retransmissionAcked || outstanding_segments.front().retransmissions > 0;
+        newest = move(outstanding_segments.front());
+        outstanding_segments.pop_front();
+    }
 
-    // iterate over outstanding list
-    // if a segment has been acknowledged, remove it from the list and set dataAcked to true
-    auto it = outstanding_segments.begin();
-    while (it != outstanding_segments.end()) {
-        TCPSegment seg = *it;
-        if (seg.header().seqno.raw_value() + seg.length_in_sequence_space() <= ackno.raw_value()) {
-            dataAcked = true;
-            it = outstanding_segments.erase(it);
-            outstanding -= seg.length_in_sequence_space();
-        } else {
-            break;
+    // if we have acknoledged new data, reset RTO (to the estimate once there is one, which
+    // drops any back-off) and restart timer if there is still outstanding datat
+    if (newest) {
+        // the time since the newest segment was sent is an RTT sample, unless the ACK might
+        // be for a retransmission (Karn's rule); an echoed timestamp says which transmission
+        // was acknowledged, so it is a sample either way. SRTT is kept in every mode, though
+        // only adaptive RTO takes its RTO from it
+        optional<uint64_t> rtt;
+        if (echoed_rtt || !retransmissionAcked) {
+            rtt = echoed_rtt.value_or(now - newest->sentAt);
+            rtt_sample(*rtt);
         }
-    }
 
-    // if we have acknoledged new data, reset RTO and restart timer if there
-    // is still outstanding datat
-    if (dataAcked) {
-        rto = _initial_retransmission_timeout;
+        rto = adaptiveRto && haveRtt ? estimated_rto() : _initial_retransmission_timeout;
         consecutive = 0;
+        if (cc) {
+            report_ack(priorInFlight - outstanding, priorInFlight, *newest, rtt);
+        }
+        dupAcks = 0;
+        if (fastRecovery) {
+            partial_ack(priorInFlight - outstanding);
+        }
         if (!outstanding_segments.empty()) {
             t.start(rto);
         } else {
             t.stop();
         }
+    } else if (fastRetransmit && duplicate) {
+        duplicate_ack();
+    } else {
+        dupAcks = 0;
     }
 }
 
+/*
+ * Function Name: duplicate_ack
+ * Description: This function counts a duplicate ACK. At the third one in a row, the oldest
+ * outstanding segment is taken to be lost: it is retransmitted right away, the congestion
+ * controller is told, and fast recovery begins, with the window inflated by the three
+ * segments that have left the network. Each further duplicate inflates it by one more
+ * segment, so new data keeps flowing while the loss is repaired. A loss that is already
+ * being repaired (after a timeout, or found with SACK) doesn't start another recovery.
+ */
+void TCPSender::duplicate_ack() {
+    dupAcks++;
+    if (fastRecovery) {
+        recoveryInflation += maxPayload;
+        return;
+    }
+    if (dupAcks != DUP_THRESH || recoveryPoint) {
+        return;
+    }
+
+    fastRecovery = true;
+    recoveryInflation = DUP_THRESH * maxPayload;
+    if (cc) {
+        cc->on_loss(outstanding, now);
+    }
+    recoveryPoint = _next_seqno;
+    retransmit(outstanding_segments.front());
+    highRetransmitted = max(highRetransmitted, outstanding_segments.front().end());
+}
+
+/*
+ * Function Name: partial_ack
+ * Args: const uint64_t acked
+ * Description: This function takes in the bytes newly acknowledged during fast recovery.
+ * Once everything that was outstanding when the loss was found is acknowledged, recovery
+ * ends and the window goes back to what the congestion controller says. An ACK short of
+ * that shows another segment from the same window was lost (RFC 6582), so the new oldest
+ * outstanding segment is retransmitted, and the inflation shrinks by the data acknowledged
+ * (plus one segment for the retransmission).
+ */
+void TCPSender::partial_ack(const uint64_t acked) {
+    if (!recoveryPoint) {
+        fastRecovery = false;
+        recoveryInflation = 0;
+        return;
+    }
+
+    recoveryInflation = (recoveryInflation > acked ? recoveryInflation - acked : 0) + maxPayload;
+    OutstandingSegment &first = outstanding_segments.front();
+    if (first.end() > highRetransmitted) {
+        retransmit(first);
+        highRetransmitted = first.end();
+    }
+}
+
+//! \details The retransmission count keeps an ACK for it from being taken as an RTT sample
+void TCPSender::retransmit(OutstandingSegment &seg) {
+    _segments_out.push(seg.segment);
+    seg.retransmissions++;
+}
+
+/*
+ * Function Name: report_ack
+ * Args: const uint64_t acked, const uint64_t priorInFlight, const OutstandingSegment &newest,
+ *       const optional<uint64_t> rtt
+ * Description: This function takes a delivery rate sample from the newest segment the ACK
+ * covers: the bytes delivered since it was sent, over the longer of the time it took to
+ * send them and the time it took to acknowledge them (as in Linux's tcp_rate.c, so ACKs
+ * that arrive bunched together don't inflate the rate). It then reports the ACK to the
+ * congestion controller.
+ */
+void TCPSender::report_ack(const uint64_t acked,
+                           const uint64_t priorInFlight,
+                           const OutstandingSegment &newest,
+                           const optional<uint64_t> rtt) {
+    delivered += acked;
+    deliveredAt = now;
+    if (appLimitedUntil != 0 && delivered > appLimitedUntil) {
+        appLimitedUntil = 0;
+    }
+
+    AckSample sample{
+        now, acked, priorInFlight, rtt, recoveryPoint.has_value(), delivered, newest.delivered, {}, newest.appLimited};
+    firstSentAt = newest.sentAt;
+    const uint64_t interval = max(now - newest.deliveredAt, newest.sentAt - newest.firstSentAt);
+    if (interval > 0) {
+        sample.delivery_rate = (delivered - newest.delivered) * 1000 / interval;
+    }
+    cc->on_ack(sample);
+}
+
+//! \details Segments sent until everything now in flight is delivered give app-limited samples
+void TCPSender::mark_app_limited() {
+    if (cc && outstanding < cc->cwnd()) {
+        appLimitedUntil = max(delivered + outstanding, uint64_t{1});
+    }
+}
+
+/*
+ * Function Name: sack_received
+ * Args: const array<TCPSackBlock, MAX_SACK_BLOCKS> &blocks, const size_t count
+ * Description: This function takes in the SACK blocks from an acknowledgment. It drops
+ * scoreboard ranges that the cumulative ackno has passed, adds every block that lies
+ * between the ackno and _next_seqno to the scoreboard, and then retransmits the holes
+ * that the scoreboard shows are lost.
+ */
+void TCPSender::sack_received(const array<TCPSackBlock, TCPOptions::MAX_SACK_BLOCKS> &blocks, const size_t count) {
+    // everything below the first outstanding segment has been acknowledged
+    const uint64_t ackAbs = outstanding_segments.empty() ? _next_seqno : outstanding_segments.front().seqno;
+    while (!sacked.empty() && sacked.begin()->first < ackAbs) {
+        const uint64_t end = sacked.begin()->second;
+        sacked.erase(sacked.begin());
+        if (end > ackAbs) {
+            sacked.emplace(ackAbs, end);
+            break;
+        }
+    }
+
+    // ignore blocks that are empty, already acknowledged, or beyond anything we sent
+    for (size_t i = 0; i < min(count, blocks.size()); i++) {
+        const uint64_t start = unwrap(blocks[i].left, _isn, _next_seqno);
+        const uint64_t end = unwrap(blocks[i].right, _isn, _next_seqno);
+        if (start < end && start >= ackAbs && end <= _next_seqno) {
+            mark_sacked(start, end);
+        }
+    }
+
+    retransmit_holes();
+}
+
+/*
+ * Function Name: mark_sacked
+ * Args: uint64_t start, uint64_t end
+ * Description: This function adds [start, end) to the SACK scoreboard, merging it with
+ * any ranges that it overlaps or touches.
+ */
+void TCPSender::mark_sacked(uint64_t start, uint64_t end) {
+    auto it = sacked.upper_bound(start);
+    if (it != sacked.begin() && prev(it)->second >= start) {
+        --it;
+        start = it->first;
+    }
+    while (it != sacked.end() && it->first <= end) {
+        end = max(end, it->second);
+        it = sacked.erase(it);
+    }
+    sacked.emplace(start, end);
+}
+
+/*
+ * Function Name: retransmit_holes
+ * Description: This function walks the outstanding segments from the highest down,
+ * counting the SACKed bytes above each one. A segment that is not SACKed itself, has
+ * not been retransmitted yet, and has more than (DUP_THRESH - 1) full segments of
+ * SACKed data above it is lost (RFC 6675), so it is retransmitted. Retransmissions go
+ * out lowest first.
+ */
+void TCPSender::retransmit_holes() {
+    if (sacked.empty()) {
+        return;
+    }
+
+    vector<OutstandingSegment *> lost;
+    uint64_t sackedAbove = 0;
+    auto range = sacked.rbegin();
+    for (size_t i = outstanding_segments.size(); i-- > 0;) {
+        OutstandingSegment *seg = &outstanding_segments[i];
+        const uint64_t start = seg->seqno;
+        const uint64_t end = seg->end();
+        if (start < highRetransmitted) {
+            break;
+        }
+
+        while (range != sacked.rend() && range->first >= end) {
+            sackedAbove += range->second - range->first;
+            ++range;
+        }
+
+        const bool isSacked = range != sacked.rend() && range->first <= start && end <= range->second;
+        if (!isSacked && sackedAbove > (DUP_THRESH - 1) * maxPayload) {
+            lost.push_back(seg);
+        }
+    }
+
+    if (lost.empty()) {
+        return;
+    }
+    for (auto seg = lost.rbegin(); seg != lost.rend(); ++seg) {
+        retransmit(**seg);
+    }
+
+    // tell the congestion controller, unless this loss is part of one it already knows about
+    if (cc && !recoveryPoint) {
+        cc->on_loss(outstanding, now);
+        recoveryPoint = _next_seqno;
+    }
+    highRetransmitted = lost.front()->end();
+}
+
 /*
  * Function Name: start
  * Args: size_t time
@@ -236,16 +585,37 @@ void Timer::timePass(size_t time) {
 void TCPSender::tick(const size_t ms_since_last_tick) {
     // tell the timer that time has passed
     t.timePass(ms_since_last_tick);
+    now += ms_since_last_tick;
+
+    // pacing: earn credit at the pacing rate (keeping no more than one tick's worth, or two
+    // segments, so an idle sender can't save up a burst) and send what it allows
+    if (cc && cc->pacing_rate()) {
+        const auto earned = static_cast<int64_t>(*cc->pacing_rate() * ms_since_last_tick / 1000);
+        pacingCredit = min(pacingCredit + earned, max(earned, static_cast<int64_t>(2 * maxPayload)));
+        if (_next_seqno > 0) {
+            fill_window();
+        }
+    }
 
     // if our timer has expired
     if (t.expired()) {
         // resend oldest segment
         if (!outstanding_segments.empty()) {
-            _segments_out.push(outstanding_segments.front());
-            // if we still have space in our window, increment consecutive and double RTO
+            retransmit(outstanding_segments.front());
+
+            // if we still have space in our window, increment consecutive and double RTO (up to maxRto)
             if (windowSize > 0) {
                 consecutive++;
-                rto = rto * 2;
+                rto = maxRto > 0 ? min<unsigned int>(rto * 2, maxRto) : rto * 2;
+                if (cc) {
+                    cc->on_timeout(outstanding, now);
+                }
+                if (cc || fastRetransmit) {
+                    recoveryPoint = _next_seqno;
+                }
+                fastRecovery = false;
+                recoveryInflation = 0;
+                dupAcks = 0;
             }
         }
         // restart timer
@@ -253,10 +623,29 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
     }
 }
 
+/*
+ * Function Name: time_until_deadline
+ * Description: This function returns how long tick() can go uncalled before it would do
+ * something: the retransmission timer runs out while segments are outstanding, and with
+ * pacing, a sender out of credit earns enough for another segment.
+ */
+optional<size_t> TCPSender::time_until_deadline() const {
+    optional<size_t> deadline;
+    if (!outstanding_segments.empty()) {
+        deadline = t.remaining();
+    }
+    if (cc && cc->pacing_rate() && pacingCredit <= 0) {
+        const uint64_t rate = max<uint64_t>(*cc->pacing_rate(), 1);
+        const size_t credit = static_cast<size_t>(-pacingCredit) * 1000 / rate + 1;
+        deadline = min(deadline.value_or(credit), credit);
+    }
+    return deadline;
+}
+
 unsigned int TCPSender::consecutive_retransmissions() const { return consecutive; }
 
 // this function sends an empty segment
 void TCPSender::send_empty_segment() {
-    TCPSegment seg = construct_TCPSegment(0);
-    safe_push_segment(seg);
+    Buffer batch;
+    safe_push_segment(construct_TCPSegment(0, batch));
 }
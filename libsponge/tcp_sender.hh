@@ -2,12 +2,17 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "ring_buffer.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <array>
 #include <functional>
-#include <list>
+#include <map>
+#include <memory>
+#include <optional>
 #include <queue>
 
 using namespace std;
@@ -47,6 +52,9 @@ class Timer {
 
     // stops timer by setting _running to false
     void stop() { _running = false; };
+
+    // returns the amount of time left before the timer runs out
+    size_t remaining() const { return _expired ? 0 : timeLeft; }
 };
 
 //! \brief The "sender" part of a TCP implementation.
@@ -56,12 +64,16 @@ class Timer {
 //! maintains the Retransmission Timer, and retransmits in-flight
 //! segments if the retransmission timer expires.
 class TCPSender {
+  public:
+    //! SACKed segments above a hole that mark it as lost (RFC 6675's DupThresh)
+    static constexpr size_t DUP_THRESH = 3;
+
   private:
     //! our initial sequence number, the number for our SYN.
     WrappingInt32 _isn;
 
     //! outbound queue of segments that the TCPSender wants sent
-    std::queue<TCPSegment> _segments_out{};
+    SegmentQueue _segments_out{};
 
     //! retransmission timer for the connection
     unsigned int _initial_retransmission_timeout;
@@ -75,20 +87,34 @@ class TCPSender {
     //! the (absolute) sequence number for the next byte to be sent
     uint64_t _next_seqno{0};
 
-    // sorted list of outstanding segments that have been sent but not necessarily acknowledged
-    list<TCPSegment> outstanding_segments;
+    // a segment that has been sent but not acknowledged yet, with what the sender knew when it
+    // first sent it (for RTT and delivery rate samples)
+    struct OutstandingSegment {
+        TCPSegment segment{};
+        uint64_t seqno = 0;                // absolute seqno of its first byte
+        uint64_t sentAt = 0;               // now when it was first sent
+        unsigned int retransmissions = 0;  // times it has been sent again since
+        uint64_t delivered = 0;            // delivered, deliveredAt, and firstSentAt when it was sent
+        uint64_t deliveredAt = 0;
+        uint64_t firstSentAt = 0;
+        bool appLimited = false;
+
+        // absolute seqno just past the segment
+        uint64_t end() const { return seqno + segment.length_in_sequence_space(); }
+    };
+
+    // segments sent but not yet acknowledged, oldest first: they are sent in order, so new ones
+    // go on the back and acknowledged ones come off the front
+    RingBuffer<OutstandingSegment> outstanding_segments;
 
     // left and right edges of the window
     WrappingInt32 l_edge;
     WrappingInt32 r_edge;
 
-    // adds a TCP segment to our list of outstanding segments
-    void addToOutstanding(TCPSegment seg);
+    // constructs a new TCP segment with length "length", its payload sliced off "batch"
+    TCPSegment construct_TCPSegment(int length, Buffer &batch);
 
-    // constructs a new TCP segment with length "length"
-    TCPSegment construct_TCPSegment(int length);
-
-    // tracks the number of bytes of segments stored in our outstanding segment list
+    // tracks the number of bytes of segments stored in our outstanding segment queue
     uint64_t outstanding;
 
     // timer used to track whether a segment has timed out
@@ -100,13 +126,105 @@ class TCPSender {
     // keeps track of the size of the window
     size_t windowSize;
 
+    // the largest payload to put in one segment (the negotiated MSS)
+    size_t maxPayload;
+
+    // RTT estimation (RFC 6298), done in every mode: if adaptiveRto is false, rto always goes back to
+    // _initial_retransmission_timeout after an ACK, as it did before. The RTO never exceeds
+    // maxRto in either mode, unless that is 0
+    bool adaptiveRto;
+    uint16_t minRto;
+    uint16_t maxRto;
+
+    // milliseconds since the sender was created (the sum of all ticks)
+    uint64_t now;
+
+    // smoothed RTT times 8 and RTT variance times 4 (in ms), so the 1/8 and 1/4 gains of
+    // RFC 6298 keep their fractional bits; haveRtt is false until the first sample
+    bool haveRtt;
+    uint64_t srttScaled;
+    uint64_t rttvarScaled;
+
+    // folds a new RTT sample into the estimate and recomputes the RTO
+    void rtt_sample(const uint64_t rtt);
+
+    // the RTO the current estimate calls for
+    unsigned int estimated_rto() const;
+
     void safe_push_segment(TCPSegment seg);
 
+    // SACK scoreboard: absolute seqno ranges [start, end) above the ackno that the receiver
+    // has reported holding, merged so they never touch or overlap
+    std::map<uint64_t, uint64_t> sacked;
+
+    // absolute seqno just past the highest segment retransmitted because of SACK information,
+    // so each hole is only retransmitted once (a lost retransmission is left to the timer)
+    uint64_t highRetransmitted;
+
+    // the congestion controller, or nullptr if only the receiver's window limits the sender
+    std::unique_ptr<CongestionControl> cc;
+
+    // while a loss is being repaired, the absolute seqno that was next when it was detected;
+    // the controller only hears about one loss per window of data (RFC 6582)
+    std::optional<uint64_t> recoveryPoint;
+
+    // delivery rate sampling for the congestion controller: bytes acknowledged so far, when the
+    // latest were, and when the newest segment acknowledged so far was sent
+    uint64_t delivered;
+    uint64_t deliveredAt;
+    uint64_t firstSentAt;
+
+    // nonzero after the sender ran out of data with room left in cwnd: segments sent before
+    // `delivered` passes this value give app-limited rate samples
+    uint64_t appLimitedUntil;
+
+    // bytes the pacing rate still lets fill_window() send; one segment may overdraw it
+    int64_t pacingCredit;
+
+    // records that fill_window() ran out of data before it ran out of cwnd
+    void mark_app_limited();
+
+    // takes a delivery rate sample from the newest segment an ACK covered, and passes it all to cc
+    void report_ack(const uint64_t acked,
+                    const uint64_t priorInFlight,
+                    const OutstandingSegment &newest,
+                    const std::optional<uint64_t> rtt);
+
+    // fast retransmit and NewReno fast recovery (RFC 5681, RFC 6582): duplicate ACKs in a row,
+    // whether the sender is repairing a loss they revealed, and the bytes each duplicate (a
+    // segment that left the network) lets it send on top of the congestion window meanwhile
+    bool fastRetransmit;
+    size_t dupAcks;
+    bool fastRecovery;
+    uint64_t recoveryInflation;
+
+    // Nagle's algorithm: hold back a segment smaller than maxPayload while data is in flight
+    bool nagle;
+
+    // counts a duplicate ACK, and retransmits the oldest outstanding segment at the third
+    void duplicate_ack();
+
+    // handles an ACK for new data during fast recovery: leaves it, or retransmits the next hole
+    void partial_ack(const uint64_t acked);
+
+    // resends an outstanding segment
+    void retransmit(OutstandingSegment &seg);
+
+    // adds the range [start, end) to the SACK scoreboard
+    void mark_sacked(uint64_t start, uint64_t end);
+
+    // retransmits every outstanding segment the scoreboard shows to be lost
+    void retransmit_holes();
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const size_t max_payload_size = TCPConfig::MAX_PAYLOAD_SIZE);
+
+    //! Initialize a TCPSender with every setting taken from `config`
+    explicit TCPSender(const TCPConfig &config);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -118,7 +236,23 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param window_size the advertised window, already scaled by the peer's window scale shift
+    //! \param carries_data the segment also occupies sequence space, so it can't be a duplicate ACK
+    //! \param echoed_rtt an RTT measured from the timestamp the ACK echoes (RFC 7323), used instead of
+    //! the sender's own timing, which Karn's rule keeps from measuring retransmissions
+    void ack_received(const WrappingInt32 ackno,
+                      const uint32_t window_size,
+                      const bool carries_data = false,
+                      const std::optional<uint64_t> echoed_rtt = {});
+
+    //! \brief SACK blocks (RFC 2018) arrived with the latest acknowledgment
+    //! \details Call after ack_received(). Segments with more than `DUP_THRESH - 1` segments'
+    //! worth of SACKed data above them are considered lost and are retransmitted right away,
+    //! instead of waiting for the retransmission timer.
+    void sack_received(const std::array<TCPSackBlock, TCPOptions::MAX_SACK_BLOCKS> &blocks, const size_t count);
+
+    //! \brief Limit the payload of segments sent from now on (e.g. to the peer's MSS option)
+    void set_max_payload_size(const size_t max_payload_size);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -128,6 +262,10 @@ class TCPSender {
 
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Milliseconds until tick() next has something to do (a retransmission, or pacing
+    //! credit for a segment), or empty if nothing is scheduled
+    std::optional<size_t> time_until_deadline() const;
     //!@}
 
     //! \name Accessors
@@ -138,6 +276,24 @@ class TCPSender {
     //! (see TCPSegment::length_in_sequence_space())
     size_t bytes_in_flight() const;
 
+    //! \brief The smoothed round-trip time in milliseconds, or empty before the first sample
+    std::optional<uint64_t> smoothed_rtt() const;
+
+    //! \brief The round-trip time variance (RTTVAR) in milliseconds
+    uint64_t rtt_variance() const { return rttvarScaled / 4; }
+
+    //! \brief The retransmission timeout currently in use, in milliseconds (including any back-off)
+    unsigned int retransmission_timeout() const { return rto; }
+
+    //! \brief The most bytes the congestion controller allows in flight (unlimited without one)
+    uint64_t congestion_window() const { return cc ? cc->cwnd() : UINT64_MAX; }
+
+    //! \brief The rate the congestion controller wants segments paced at (bytes/s), if any
+    std::optional<uint64_t> pacing_rate() const { return cc ? cc->pacing_rate() : std::nullopt; }
+
+    //! \brief The largest payload this sender puts in one segment
+    size_t max_payload_size() const { return maxPayload; }
+
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
@@ -145,7 +301,7 @@ class TCPSender {
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
     //! (ackno and window size) before sending.
-    std::queue<TCPSegment> &segments_out() { return _segments_out; }
+    SegmentQueue &segments_out() { return _segments_out; }
     //!@}
 
     //! \name What is the next sequence number? (used for testing)
@@ -7,11 +7,24 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_storage and _starting_offset == _ending_offset) {
         _storage.reset();
     }
 }
 
+Buffer Buffer::slice(const size_t pos, const size_t len) const {
+    if (pos + len > size()) {
+        throw out_of_range("Buffer::slice");
+    }
+    Buffer ret;
+    if (len > 0) {
+        ret._storage = _storage;
+        ret._starting_offset = _starting_offset + pos;
+        ret._ending_offset = ret._starting_offset + len;
+    }
+    return ret;
+}
+
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
@@ -73,6 +73,27 @@ string FileDescriptor::read(const size_t limit) {
     return ret;
 }
 
+//! \param[in] regions are the memory regions to be filled, in order; fewer bytes than their total size may be read
+//! \returns the number of bytes read
+size_t FileDescriptor::read_into(const vector<iovec> &regions) {
+    size_t size_to_read = 0;
+    for (const auto &region : regions) {
+        size_to_read += region.iov_len;
+    }
+
+    const ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), regions.data(), regions.size()));
+    if (size_to_read > 0 && bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+    if (bytes_read > static_cast<ssize_t>(size_to_read)) {
+        throw runtime_error("readv() read more than requested");
+    }
+
+    register_read();
+
+    return bytes_read;
+}
+
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     size_t total_bytes_written = 0;
 
@@ -0,0 +1,76 @@
+#ifndef SPONGE_LIBSPONGE_RING_BUFFER_HH
+#define SPONGE_LIBSPONGE_RING_BUFFER_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//! \brief A FIFO sequence stored in a circular array that doubles when it is full
+//!
+//! Unlike std::deque, which frees and allocates a block every few elements as they are pushed
+//! on the back and popped off the front, a RingBuffer reuses its slots, so a queue that is
+//! filled and drained at a steady rate stops allocating once it has grown to its working size.
+//! It provides what std::queue needs of its container, plus indexing from the front.
+//! Popped slots are reset to `T{}`, so they don't hold on to resources.
+template <typename T>
+class RingBuffer {
+  private:
+    std::vector<T> slots{};  // capacity is zero or a power of two
+    size_t head = 0;         // slot of the front element
+    size_t count = 0;        // number of elements
+
+    size_t slot(const size_t i) const { return (head + i) & (slots.size() - 1); }
+
+    void grow() {
+        std::vector<T> bigger(std::max<size_t>(2 * slots.size(), 16));
+        for (size_t i = 0; i < count; i++) {
+            bigger[i] = std::move(slots[slot(i)]);
+        }
+        slots = std::move(bigger);
+        head = 0;
+    }
+
+  public:
+    //! \name Types std::queue expects of its container
+    //!@{
+    using value_type = T;
+    using reference = T &;
+    using const_reference = const T &;
+    using size_type = size_t;
+    //!@}
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    //! \brief The element `i` places from the front
+    T &operator[](const size_t i) { return slots[slot(i)]; }
+    const T &operator[](const size_t i) const { return slots[slot(i)]; }
+
+    T &front() { return slots[head]; }
+    const T &front() const { return slots[head]; }
+    T &back() { return slots[slot(count - 1)]; }
+    const T &back() const { return slots[slot(count - 1)]; }
+
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T &emplace_back(Args &&... args) {
+        if (count == slots.size()) {
+            grow();
+        }
+        T &ret = slots[slot(count)];
+        ret = T(std::forward<Args>(args)...);
+        count++;
+        return ret;
+    }
+
+    void pop_front() {
+        slots[head] = T{};
+        head = slot(1);
+        count--;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_RING_BUFFER_HH
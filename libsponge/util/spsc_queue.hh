@@ -0,0 +1,94 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+#define SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//! \brief A bounded FIFO queue between exactly two threads: one that pushes, and one that pops
+//!
+//! The slots are a fixed circular array, and each side owns one index, which only it writes:
+//! the producer publishes a slot by storing `tail` with release order after filling it, and the
+//! consumer gives a slot back by storing `head` the same way after emptying it. Neither side
+//! takes a lock or waits for the other; a full queue refuses the push, and an empty one the pop.
+//! Each side also keeps a cached copy of the other's index, so it only reads the shared one (and
+//! so only moves its cache line between cores) when the cached copy says the queue looks full or
+//! empty.
+//!
+//! push() may only be called from one thread at a time, and likewise pop(); any other member
+//! may be called from either, but is only a snapshot.
+template <typename T>
+class SPSCQueue {
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    static size_t round_up(const size_t n) {
+        size_t size = 2;
+        while (size < n) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    // slots; a power of two, so an index is reduced by masking, and the indices are never reduced
+    // themselves (tail - head is the size even after they wrap around 2^64)
+    std::vector<T> slots;
+    const size_t mask;
+
+    // written by the consumer only
+    alignas(CACHE_LINE) std::atomic<size_t> head{0};
+    size_t tailCache = 0;
+
+    // written by the producer only
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0};
+    size_t headCache = 0;
+
+  public:
+    //! \param[in] capacity the most elements the queue holds, rounded up to a power of two
+    explicit SPSCQueue(const size_t capacity) : slots(round_up(capacity)), mask(slots.size() - 1) {}
+
+    //! \brief Append `value` (producer only)
+    //! \returns false, leaving `value` untouched, if the queue is full
+    bool push(T &&value) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache == slots.size()) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache == slots.size()) {
+                return false;
+            }
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Take the element at the front (consumer only)
+    //! \returns false, leaving `value` untouched, if the queue is empty
+    bool pop(T &value) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tailCache) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h == tailCache) {
+                return false;
+            }
+        }
+        value = std::move(slots[h & mask]);
+        slots[h & mask] = T{};
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief The number of elements, as of some moment during the call
+    size_t size() const {
+        // head first: it never passes tail, so the difference is never negative
+        const size_t h = head.load(std::memory_order_acquire);
+        return tail.load(std::memory_order_acquire) - h;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return slots.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_QUEUE_HH
@@ -0,0 +1,151 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+void TimerWheel::place(const Entry &entry) {
+    if (entry.deadline < current) {
+        overdue.push_back(entry);
+        return;
+    }
+
+    // a deadline beyond the top level's span waits in the last slot that reaches, and is placed
+    // again from there
+    const uint64_t when = min(entry.deadline, current + ((uint64_t{1} << SPAN_BITS) - 1));
+
+    // the lowest level whose slots, from the one `current` is in, reach `when` (the top level's
+    // slots behind `current` stand for the next time around)
+    size_t level = 0;
+    while (level < LEVELS - 1 and (when >> (SLOT_BITS * (level + 1))) != (current >> (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    slots[level][(when >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(entry);
+    counts[level]++;
+}
+
+void TimerWheel::cascade(const size_t level) {
+    vector<Entry> &slot = slots[level][(current >> (SLOT_BITS * level)) & (SLOTS - 1)];
+    if (slot.empty()) {
+        return;
+    }
+    counts[level] -= slot.size();
+    for (const Entry &entry : slot) {
+        const auto it = deadlines.find(entry.key);
+        if (it != deadlines.end() and it->second == entry.deadline) {
+            place(entry);
+        }
+    }
+    slot.clear();
+}
+
+void TimerWheel::schedule(const Key key, const uint64_t deadline) {
+    const auto [it, inserted] = deadlines.try_emplace(key, deadline);
+    if (not inserted) {
+        if (it->second == deadline) {
+            return;
+        }
+        it->second = deadline;
+    }
+    place({key, deadline});
+}
+
+void TimerWheel::cancel(const Key key) { deadlines.erase(key); }
+
+optional<uint64_t> TimerWheel::deadline(const Key key) const {
+    const auto it = deadlines.find(key);
+    if (it == deadlines.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+void TimerWheel::advance(const uint64_t now, vector<Key> &expired) {
+    // deadlines that were already past when they were scheduled come first
+    if (not overdue.empty()) {
+        sort(overdue.begin(), overdue.end(), [](const Entry &a, const Entry &b) { return a.deadline < b.deadline; });
+        for (const Entry &entry : overdue) {
+            const auto it = deadlines.find(entry.key);
+            if (it != deadlines.end() and it->second == entry.deadline) {
+                deadlines.erase(it);
+                expired.push_back(entry.key);
+            }
+        }
+        overdue.clear();
+    }
+
+    while (current <= now) {
+        // at the start of a slot at some level, move its entries down, highest level first
+        for (size_t level = LEVELS - 1; level > 0; level--) {
+            if ((current & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+
+        // expire what is due at level 0, and put back anything clamped into this slot early
+        vector<Entry> &slot = slots[0][current & (SLOTS - 1)];
+        if (not slot.empty()) {
+            vector<Entry> due;
+            due.swap(slot);
+            counts[0] -= due.size();
+            for (const Entry &entry : due) {
+                const auto it = deadlines.find(entry.key);
+                if (it == deadlines.end() or it->second != entry.deadline) {
+                    continue;
+                }
+                if (entry.deadline <= current) {
+                    deadlines.erase(it);
+                    expired.push_back(entry.key);
+                } else {
+                    place(entry);
+                }
+            }
+            // keep the slot's capacity for next time around
+            if (slot.empty()) {
+                due.clear();
+                slot.swap(due);
+            }
+        }
+
+        // skip the empty slots: to the next millisecond if level 0 has entries, otherwise to the
+        // next slot of the lowest level that does (nothing below it can need a visit before then)
+        size_t level = 0;
+        while (level < LEVELS and counts[level] == 0) {
+            level++;
+        }
+        uint64_t next = now + 1;
+        if (level < LEVELS) {
+            next = ((current >> (SLOT_BITS * level)) + 1) << (SLOT_BITS * level);
+        }
+        current = min(next, now + 1);
+    }
+}
+
+optional<uint64_t> TimerWheel::next_deadline() const {
+    if (not overdue.empty()) {
+        return min_element(overdue.begin(), overdue.end(), [](const Entry &a, const Entry &b) {
+                   return a.deadline < b.deadline;
+               })->deadline;
+    }
+
+    // the start of the first nonempty slot at each level; a level can come before a lower one
+    // while advance() hasn't yet reached the start of (and cascaded) the slot `current` is in
+    optional<uint64_t> earliest;
+    for (size_t level = 0; level < LEVELS; level++) {
+        if (counts[level] == 0) {
+            continue;
+        }
+        // look at the slots from the one `current` is in, which still counts if advance() hasn't
+        // reached its start yet (always at level 0); the top level's comes around again
+        const size_t shift = SLOT_BITS * level;
+        const bool started = (current & ((uint64_t{1} << shift) - 1)) != 0;
+        for (uint64_t k = started ? 1 : 0; k <= SLOTS; k++) {
+            if (not slots[level][((current >> shift) + k) & (SLOTS - 1)].empty()) {
+                const uint64_t start = max(current, ((current >> shift) + k) << shift);
+                earliest = min(earliest.value_or(start), start);
+                break;
+            }
+        }
+    }
+    return earliest;
+}
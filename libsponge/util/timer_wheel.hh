@@ -0,0 +1,81 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! \brief A hierarchical timing wheel: a set of keys, each with a deadline in milliseconds
+//!
+//! Each level has 64 slots, each covering 64 times the span of a slot one level down (1 ms at level 0),
+//! so scheduling and cancelling a deadline take constant time, and advance() only touches the slots
+//! it passes, skipping runs of empty ones. A deadline far enough ahead sits in a high level until
+//! its slot comes up, then moves down (cascades) towards level 0, where it expires.
+//!
+//! The wheel holds keys rather than callbacks, so the owner decides what expiry means, and
+//! whatever a key names can move in memory. Each key has at most one deadline: scheduling it again
+//! replaces the old one.
+class TimerWheel {
+  public:
+    using Key = uint64_t;
+
+    static constexpr size_t SLOT_BITS = 6;               //!< log2 of the slots in each level
+    static constexpr size_t SLOTS = 1 << SLOT_BITS;      //!< Slots in each level
+    static constexpr size_t LEVELS = 8;                  //!< Levels, enough for deadlines 8900 years ahead
+    static constexpr size_t SPAN_BITS = SLOT_BITS * LEVELS;
+
+  private:
+    struct Entry {
+        Key key = 0;
+        uint64_t deadline = 0;
+    };
+
+    // entries by level and slot; an entry whose key has since been cancelled or rescheduled
+    // (so `deadlines` no longer matches it) is stale, and is dropped when its slot is reached
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> slots{};
+
+    // entries whose deadlines had already passed when they were scheduled
+    std::vector<Entry> overdue{};
+
+    // entries in each level, stale ones included
+    std::array<size_t, LEVELS> counts{};
+
+    // the live deadline of each key
+    std::unordered_map<Key, uint64_t> deadlines{};
+
+    // the next millisecond advance() will visit: everything before it has been handled
+    uint64_t current = 0;
+
+    // puts an entry in the slot for its deadline, as seen from `current` (or with the overdue ones)
+    void place(const Entry &entry);
+
+    // moves the entries in the slot that starts at `current` at `level` down the wheel
+    void cascade(const size_t level);
+
+  public:
+    //! \brief Set (or move) `key`'s deadline to `deadline`; a deadline already past expires at the next advance()
+    void schedule(const Key key, const uint64_t deadline);
+
+    //! \brief Remove `key`'s deadline, if it has one
+    void cancel(const Key key);
+
+    //! \brief The deadline `key` has, if any
+    std::optional<uint64_t> deadline(const Key key) const;
+
+    //! \brief Move time forward to `now`
+    //! \param[out] expired the keys whose deadlines are at or before `now` are appended, in deadline order
+    void advance(const uint64_t now, std::vector<Key> &expired);
+
+    //! \brief A time no later than the earliest deadline (exact unless it was cancelled), or empty if there is none
+    std::optional<uint64_t> next_deadline() const;
+
+    //! \brief How many keys have deadlines
+    size_t size() const { return deadlines.size(); }
+
+    bool empty() const { return deadlines.empty(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
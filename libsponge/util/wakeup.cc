@@ -0,0 +1,39 @@
+#include "wakeup.hh"
+
+#include "util.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+Wakeup::Wakeup() : _fd(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {}
+
+//! \details The fence keeps the sleeper's last look for work from being done before the store,
+//! and the one in notify() does the same for the producer's work and its load, so at least one
+//! of the two sees the other's write.
+void Wakeup::prepare() {
+    _waiting.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void Wakeup::notify() {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (_waiting.load(memory_order_relaxed) and _waiting.exchange(false, memory_order_relaxed)) {
+        const uint64_t one = 1;
+        SystemCall("write", ::write(_fd.fd_num(), &one, sizeof(one)));
+    }
+}
+
+void Wakeup::wait(const int timeout_ms) {
+    pollfd pfd{_fd.fd_num(), POLLIN, 0};
+    SystemCall("poll", ::poll(&pfd, 1, timeout_ms), EINTR);
+    _waiting.store(false, memory_order_relaxed);
+
+    // reset the count, if there was a notification
+    uint64_t count = 0;
+    SystemCall("read", ::read(_fd.fd_num(), &count, sizeof(count)), EAGAIN);
+}
@@ -0,0 +1,39 @@
+#ifndef SPONGE_LIBSPONGE_WAKEUP_HH
+#define SPONGE_LIBSPONGE_WAKEUP_HH
+
+#include "file_descriptor.hh"
+
+#include <atomic>
+
+//! \brief Lets any thread wake one that sleeps in [poll(2)](\ref man2::poll) for want of work
+//!
+//! The sleeper calls prepare(), then looks for work one last time, and only then sleeps: in
+//! wait(), or in an EventLoop that polls fd() (whose rule must read fd() when it is readable).
+//! A thread that makes work available calls notify(), which writes to the
+//! [eventfd(2)](\ref man2::eventfd) only if prepare() was called since the last notification, so
+//! a sleeper that is awake costs its producers no system calls. Since prepare() comes before the
+//! sleeper's last look, work made available after that look always finds it prepared.
+class Wakeup {
+  private:
+    FileDescriptor _fd;
+    std::atomic<bool> _waiting{false};
+
+  public:
+    //! Creates the eventfd
+    Wakeup();
+
+    //! \brief The sleeper is about to look for work one last time before it sleeps
+    void prepare();
+
+    //! \brief Wake the sleeper, if it is (or is about to be) asleep
+    void notify();
+
+    //! \brief Sleep until notified, or for up to `timeout_ms` milliseconds (-1 for no limit)
+    //! \note Returns straight away if a notification came since the last wait()
+    void wait(const int timeout_ms);
+
+    //! \brief The eventfd, readable once notified, for a sleeper that polls it among others
+    FileDescriptor &fd() { return _fd; }
+};
+
+#endif  // SPONGE_LIBSPONGE_WAKEUP_HH
@@ -0,0 +1,193 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "stream_reassembler.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"chunked write-write-pop-pop", 15, ByteStream::Storage::Chunked};
+
+            test.execute(Write{"cat"}.with_bytes_written(3));
+            test.execute(Write{"tac"}.with_bytes_written(3));
+            test.execute(BytesWritten{6});
+            test.execute(RemainingCapacity{9});
+            test.execute(BufferSize{6});
+            test.execute(Peek{"catt"});
+
+            // pop across the boundary between the two chunks
+            test.execute(Pop{4});
+            test.execute(BytesRead{4});
+            test.execute(RemainingCapacity{13});
+            test.execute(BufferSize{2});
+            test.execute(Peek{"ac"});
+
+            test.execute(EndInput{});
+            test.execute(Eof{false});
+            test.execute(Pop{2});
+            test.execute(BufferEmpty{true});
+            test.execute(Eof{true});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked overwrite", 2, ByteStream::Storage::Chunked};
+
+            test.execute(Write{"cat"}.with_bytes_written(2));
+            test.execute(RemainingCapacity{0});
+            test.execute(Peek{"ca"});
+            test.execute(Pop{1});
+            test.execute(Write{"tac"}.with_bytes_written(1));
+            test.execute(Peek{"at"});
+            test.execute(BytesWritten{3});
+            test.execute(BytesRead{1});
+        }
+
+        // a Buffer that fits is kept by reference, not copied
+        {
+            ByteStream stream{10, ByteStream::Storage::Chunked};
+            Buffer payload{string("hello")};
+            const char *storage = payload.str().data();
+
+            if (stream.write(payload) != 5) {
+                throw runtime_error("chunked write of a Buffer accepted the wrong number of bytes");
+            }
+            stream.write(Buffer{string("world")});
+
+            const BufferList peeked = stream.peek_buffers();
+            if (peeked.buffers().size() != 2 or peeked.buffers().front().str().data() != storage) {
+                throw runtime_error("chunked ByteStream copied a Buffer that fit");
+            }
+            if (peeked.concatenate() != "helloworld" or stream.read(7) != "hellowo") {
+                throw runtime_error("chunked ByteStream returned the wrong bytes");
+            }
+            if (stream.peek_buffers().concatenate() != "rld") {
+                throw runtime_error("chunked ByteStream peek_buffers() after a partial pop was wrong");
+            }
+        }
+
+        // peek_buffer() slices a chunk that holds all the bytes, and copies otherwise
+        {
+            ByteStream stream{5, ByteStream::Storage::Chunked};
+            Buffer payload{string("hello world")};
+            const char *storage = payload.str().data();
+
+            // only part of the Buffer fits, and the stream keeps a slice of it
+            if (stream.write(payload) != 5) {
+                throw runtime_error("chunked write of a Buffer accepted the wrong number of bytes");
+            }
+            const Buffer peeked = stream.peek_buffer(3);
+            if (peeked.str() != "hel" or peeked.str().data() != storage) {
+                throw runtime_error("chunked ByteStream peek_buffer() copied bytes from within one chunk");
+            }
+            stream.pop_output(3);
+            if (stream.peek_buffer(10).str() != "lo" or peeked.slice(1, 2).str() != "el") {
+                throw runtime_error("Buffer slices returned the wrong bytes");
+            }
+        }
+
+        // the contiguous stream hands out the same bytes through peek_buffers()
+        {
+            ByteStream stream{4};
+            stream.write(Buffer{string("abc")});
+            stream.pop_output(2);
+            stream.write("def");
+            if (stream.peek_buffers().concatenate() != "cdef") {
+                throw runtime_error("contiguous ByteStream peek_buffers() returned the wrong bytes");
+            }
+        }
+
+        // peek_views() exposes the stream's storage without copying, in both modes
+        {
+            ByteStream stream{4};
+            stream.write("abc");
+            stream.pop_output(2);
+            stream.write("def");
+
+            // "cdef" wraps around the end of the circular buffer
+            const auto iovecs = stream.peek_views(3).as_iovecs();
+            if (iovecs.size() != 2 or string(static_cast<const char *>(iovecs[0].iov_base), iovecs[0].iov_len) != "cd" or
+                string(static_cast<const char *>(iovecs[1].iov_base), iovecs[1].iov_len) != "e") {
+                throw runtime_error("contiguous ByteStream peek_views() returned the wrong views");
+            }
+        }
+
+        {
+            ByteStream stream{10, ByteStream::Storage::Chunked};
+            stream.write(Buffer{string("ab")});
+            stream.write(Buffer{string("cde")});
+            stream.pop_output(1);
+            if (stream.peek_views(3).size() != 3 or stream.peek_views(3).as_iovecs().size() != 2 or
+                stream.peek_views(0).size() != 0) {
+                throw runtime_error("chunked ByteStream peek_views() returned the wrong views");
+            }
+        }
+
+        // reserve_write()/commit_write() let a writer fill the free space in place
+        for (const auto storage : {ByteStream::Storage::Contiguous, ByteStream::Storage::Chunked}) {
+            ByteStream stream{4, storage};
+            stream.write("ab");
+            stream.pop_output(1);
+
+            const string data = "wxyz";
+            size_t copied = 0;
+            for (const auto &region : stream.reserve_write(10)) {
+                memcpy(region.iov_base, data.data() + copied, region.iov_len);
+                copied += region.iov_len;
+            }
+            if (copied != 3) {
+                throw runtime_error("ByteStream reserve_write() handed out the wrong amount of space");
+            }
+
+            // only two of the three reserved bytes were actually filled in
+            stream.commit_write(2);
+            if (stream.buffer_size() != 3 or stream.bytes_written() != 4 or stream.read(3) != "bwx") {
+                throw runtime_error("ByteStream commit_write() stored the wrong bytes");
+            }
+
+            // committing more than was reserved, or without a reservation, adds only what was filled
+            stream.write("c");
+            for (const auto &region : stream.reserve_write(1)) {
+                memcpy(region.iov_base, "d", 1);
+            }
+            stream.commit_write(4);
+            stream.commit_write(4);
+            if (stream.buffer_size() != 2 or stream.bytes_written() != 6 or stream.read(2) != "cd") {
+                throw runtime_error("ByteStream commit_write() added bytes that weren't reserved");
+            }
+        }
+
+        // a TCPReceiver hands in-order payloads to its reader without copying them
+        for (const auto backend : {StreamReassembler::Backend::IntervalMap, StreamReassembler::Backend::Bitmap}) {
+            TCPReceiver receiver{100, backend};
+            TCPSegment syn;
+            syn.header().syn = true;
+            receiver.segment_received(syn);
+
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{1};
+            seg.payload() = string("hello");
+            receiver.segment_received(seg);
+
+            const Buffer peeked = receiver.stream_out().peek_buffer(5);
+            if (peeked.str() != "hello") {
+                throw runtime_error("TCPReceiver delivered the wrong bytes");
+            }
+            if (backend == StreamReassembler::Backend::IntervalMap and
+                peeked.str().data() != seg.payload().str().data()) {
+                throw runtime_error("TCPReceiver copied an in-order payload");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+#include "congestion_control.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+// acknowledges a whole window in one ACK, one round trip of `rtt` ms after `now`
+static void ack_window(CongestionControl &cc, uint64_t &now, const uint64_t rtt) {
+    now += rtt;
+    cc.on_ack({now, cc.cwnd(), cc.cwnd(), rtt, false});
+}
+
+int main() {
+    try {
+        constexpr size_t mss = 1000;
+
+        check(CongestionControl::make(CongestionControl::Algorithm::None, mss) == nullptr,
+              "None should not make a controller");
+
+        // NewReno doubles the window every round trip in slow start, then adds one segment per round trip
+        {
+            NewReno reno{mss};
+            uint64_t now = 0;
+            check(reno.cwnd() == CongestionControl::INITIAL_WINDOW * mss, "wrong initial window");
+
+            // ACKs for one segment each grow the window by one segment each
+            for (unsigned i = 0; i < 10; i++) {
+                reno.on_ack({now, mss, reno.cwnd(), {}, false});
+            }
+            check(reno.cwnd() == 20 * mss, "slow start should double the window in a round trip");
+
+            reno.on_loss(20 * mss, now);
+            check(reno.cwnd() == 10 * mss, "a loss should halve the window");
+            check(reno.slow_start_threshold() == 10 * mss, "a loss should set ssthresh to half the flight");
+
+            // no growth while the loss is being repaired
+            reno.on_ack({now, 5 * mss, 10 * mss, {}, true});
+            check(reno.cwnd() == 10 * mss, "the window grew during recovery");
+
+            ack_window(reno, now, 100);
+            check(reno.cwnd() == 11 * mss, "congestion avoidance should add one segment per round trip");
+            ack_window(reno, now, 100);
+            check(reno.cwnd() == 12 * mss, "congestion avoidance should add one segment per round trip");
+
+            reno.on_timeout(12 * mss, now);
+            check(reno.cwnd() == mss, "a timeout should go back to one segment");
+            check(reno.slow_start_threshold() == 6 * mss, "a timeout should set ssthresh to half the flight");
+
+            reno.on_loss(mss, now);
+            check(reno.cwnd() == 2 * mss, "the window should never drop below two segments after a loss");
+        }
+
+        // CUBIC grows quickly back towards the window of the last loss, flattens out there, then probes beyond it
+        {
+            Cubic cubic{mss};
+            uint64_t now = 0;
+            while (cubic.cwnd() < 1000 * mss) {
+                cubic.on_ack({now, 2 * mss, cubic.cwnd(), {}, false});
+            }
+            const uint64_t lossWindow = cubic.cwnd();
+
+            cubic.on_loss(lossWindow, now);
+            check(cubic.cwnd() == uint64_t(lossWindow * Cubic::BETA), "a loss should keep BETA of the window");
+
+            // K = cbrt(wMax * (1 - BETA) / C) = about 9.09 s to get back to wMax
+            uint64_t at2s = 0, at4s = 0, at8s = 0, at10s = 0;
+            while (now < 15000) {
+                ack_window(cubic, now, 100);
+                at2s = now == 2000 ? cubic.cwnd() : at2s;
+                at4s = now == 4000 ? cubic.cwnd() : at4s;
+                at8s = now == 8000 ? cubic.cwnd() : at8s;
+                at10s = now == 10000 ? cubic.cwnd() : at10s;
+                if (now == 9000) {
+                    check(cubic.cwnd() > lossWindow * 99 / 100 and cubic.cwnd() < lossWindow * 101 / 100,
+                          "CUBIC should be back at the window of the loss after K seconds");
+                }
+            }
+            check(at4s > at2s and at8s > at4s, "CUBIC should keep growing towards wMax");
+            check(at4s - at2s > at10s - at8s, "CUBIC should grow more slowly near wMax");
+            check(cubic.cwnd() > lossWindow * 105 / 100, "CUBIC should probe beyond wMax");
+
+            cubic.on_timeout(cubic.cwnd(), now);
+            check(cubic.cwnd() == mss, "a timeout should go back to one segment");
+        }
+
+        // BBR fills the pipe, drains the queue it built, then paces at the bandwidth it measured
+        {
+            constexpr uint64_t rate = 1000000;  // bytes/s
+            constexpr uint64_t rtt = 20;
+            constexpr uint64_t bdp = rate * rtt / 1000;
+            BBR bbr{mss};
+            uint64_t now = 0, delivered = 0;
+            // one ACK per round trip, for 10 segments, each sampling the same delivery rate
+            const auto ack_round = [&](const uint64_t inFlight, const uint64_t sampleRtt) {
+                now += sampleRtt;
+                const uint64_t prior = delivered;
+                delivered += 10 * mss;
+                bbr.on_ack({now, 10 * mss, inFlight, sampleRtt, false, delivered, prior, rate, false});
+            };
+
+            check(bbr.mode() == BBR::Mode::Startup, "BBR should start in Startup");
+            check(not bbr.pacing_rate(), "BBR can't pace before it has measured anything");
+            for (unsigned i = 0; i < 4; i++) {
+                ack_round(bbr.cwnd(), rtt);
+            }
+            check(bbr.mode() == BBR::Mode::Drain, "three round trips without more bandwidth should end Startup");
+            check(bbr.bottleneck_bandwidth() == rate, "wrong bottleneck bandwidth");
+            check(bbr.min_rtt() == rtt, "wrong min RTT");
+            check(*bbr.pacing_rate() < rate, "Drain should pace below the bandwidth");
+
+            ack_round(bdp + 10 * mss, rtt);
+            check(bbr.mode() == BBR::Mode::ProbeBW, "Drain should end once one BDP is in flight");
+            check(*bbr.pacing_rate() == rate * 5 / 4, "ProbeBW should start by probing for more bandwidth");
+            for (unsigned i = 0; i < 8; i++) {
+                ack_round(bdp, rtt + 1);
+            }
+            check(bbr.cwnd() == 2 * bdp, "ProbeBW should allow two BDPs in flight");
+
+            bbr.on_loss(bbr.cwnd(), now);
+            check(bbr.cwnd() == 2 * bdp, "a loss shouldn't change BBR's window");
+
+            // no RTT as low as the min RTT for 10 s: measure it again with the queue drained
+            while (bbr.mode() != BBR::Mode::ProbeRTT) {
+                check(now < BBR::MIN_RTT_WINDOW_MS + 100, "BBR should go to ProbeRTT after 10 s");
+                ack_round(bdp, rtt + 5);
+            }
+            check(bbr.cwnd() == BBR::MIN_CWND_SEGMENTS * mss, "ProbeRTT should keep only a few segments in flight");
+            const uint64_t probeStart = now;
+            while (bbr.mode() == BBR::Mode::ProbeRTT) {
+                check(now < probeStart + 2 * BBR::PROBE_RTT_MS, "ProbeRTT should last about 200 ms");
+                ack_round((BBR::MIN_CWND_SEGMENTS + 10) * mss, rtt);
+            }
+            check(bbr.mode() == BBR::Mode::ProbeBW, "ProbeRTT should go back to ProbeBW");
+            check(bbr.cwnd() == 2 * bdp, "ProbeRTT should restore the window");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+// takes every segment x has queued
+static vector<TCPSegment> take(TCPConnection &x) {
+    vector<TCPSegment> segs;
+    while (not x.segments_out().empty()) {
+        segs.push_back(move(x.segments_out().front()));
+        x.segments_out().pop();
+    }
+    return segs;
+}
+
+// passes every segment x has queued to y, and returns how many there were
+static size_t deliver(TCPConnection &x, TCPConnection &y) {
+    const vector<TCPSegment> segs = take(x);
+    for (const TCPSegment &seg : segs) {
+        y.segment_received(seg);
+    }
+    return segs.size();
+}
+
+static void handshake(TCPConnection &x, TCPConnection &y) {
+    x.connect();
+    check(deliver(x, y) == 1, "x should send a SYN");
+    check(deliver(y, x) == 1, "y should answer with a SYN/ACK");
+    check(deliver(x, y) == 1, "the SYN/ACK should be acknowledged right away");
+    check(y.segments_out().empty(), "y shouldn't acknowledge a bare ACK");
+}
+
+int main() {
+    try {
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+        TCPConfig cfg;
+        cfg.delayed_ack = true;
+
+        {
+            TCPConfig plain;
+            TCPConnection x{plain}, y{plain};
+            handshake(x, y);
+            x.write("request");
+            check(deliver(x, y) == 1, "x should send its request");
+            check(deliver(y, x) == 1, "without delayed ACKs, y should acknowledge at once");
+        }
+
+        {
+            TCPConnection x{cfg}, y{cfg};
+            handshake(x, y);
+
+            // the request's ACK rides on the response
+            x.write("request");
+            const vector<TCPSegment> request = take(x);
+            check(request.size() == 1, "x should send its request");
+            y.segment_received(request[0]);
+            check(y.segments_out().empty(), "y should delay its ACK");
+            y.write("response");
+            const vector<TCPSegment> response = take(y);
+            check(response.size() == 1 and response[0].payload().size() == 8, "y should send one segment");
+            check(response[0].header().ack and response[0].header().ackno == request[0].header().seqno + 7,
+                  "the response should acknowledge the request");
+            x.segment_received(response[0]);
+            check(x.bytes_in_flight() == 0, "the request should be acknowledged");
+
+            // with nothing to carry it, the ACK goes out on its own after the timeout
+            check(x.segments_out().empty(), "x should delay its ACK");
+            x.tick(cfg.delayed_ack_timeout - 1);
+            check(x.segments_out().empty(), "x shouldn't ACK before the timeout");
+            x.tick(1);
+            check(deliver(x, y) == 1 and y.bytes_in_flight() == 0, "x should ACK at the timeout");
+            check(not x.time_until_deadline(), "x should need no ticks once it has ACKed");
+            x.tick(10 * cfg.delayed_ack_timeout);
+            check(x.segments_out().empty(), "x shouldn't ACK twice");
+        }
+
+        {
+            // data that arrives before the peer's SYN has nothing to acknowledge, so it arms no
+            // delayed ACK: x's only deadline stays its SYN's retransmission
+            TCPConnection x{cfg}, y{cfg};
+            x.connect();
+            const TCPSegment syn = take(x).at(0);
+            TCPSegment early;
+            early.header().seqno = WrappingInt32{1234};
+            early.payload() = string("early");
+            x.segment_received(early);
+            check(x.segments_out().empty(), "x shouldn't answer data before a SYN");
+            check(x.time_until_deadline() == x.retransmission_timeout(), "x should only wait to retransmit");
+            x.tick(cfg.delayed_ack_timeout);
+            check(x.segments_out().empty(), "x shouldn't send a segment without an ACK");
+            check(x.time_until_deadline() == x.retransmission_timeout() - cfg.delayed_ack_timeout,
+                  "x should still only wait to retransmit");
+
+            // and once the SYN/ACK arrives, exactly one delayed ACK goes out for data after it
+            y.segment_received(syn);
+            x.segment_received(take(y).at(0));
+            check(deliver(x, y) == 1, "x should ACK the SYN/ACK");
+            y.write("data");
+            check(deliver(y, x) == 1, "y should send its data");
+            x.tick(cfg.delayed_ack_timeout);
+            check(take(x).size() == 1, "x should send one delayed ACK");
+            check(not x.time_until_deadline(), "x's deadline should go back to none");
+            x.tick(cfg.delayed_ack_timeout);
+            check(x.segments_out().empty(), "x shouldn't ACK again");
+        }
+
+        {
+            TCPConnection x{cfg}, y{cfg};
+            handshake(x, y);
+
+            // every second full segment is acknowledged
+            x.write(string(4 * mss, 'x'));
+            const vector<TCPSegment> segs = take(x);
+            check(segs.size() == 4, "x should send four segments");
+            for (size_t i = 0; i < segs.size(); i++) {
+                y.segment_received(segs[i]);
+                check(y.segments_out().size() == i % 2, "y should ACK every second full segment");
+                take(y);
+            }
+            check(y.inbound_stream().buffer_size() == 4 * mss, "the data should arrive");
+        }
+
+        {
+            TCPConnection x{cfg}, y{cfg};
+            handshake(x, y);
+
+            // out-of-order data, and data that fills the hole, are acknowledged at once
+            x.write("a");
+            x.write("b");
+            x.write("c");
+            const vector<TCPSegment> segs = take(x);
+            check(segs.size() == 3, "x should send three segments");
+            y.segment_received(segs[0]);
+            check(y.segments_out().empty(), "y should delay the ACK for in-order data");
+            y.segment_received(segs[2]);
+            check(take(y).size() == 1, "y should ACK out-of-order data at once");
+            y.segment_received(segs[1]);
+            const vector<TCPSegment> acks = take(y);
+            check(acks.size() == 1 and acks[0].header().ackno == segs[2].header().seqno + 1,
+                  "y should ACK the filled hole at once");
+
+            // so is a FIN
+            x.end_input_stream();
+            check(deliver(x, y) == 1, "x should send a FIN");
+            check(deliver(y, x) == 1, "y should ACK the FIN at once");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
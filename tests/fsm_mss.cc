@@ -0,0 +1,107 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+// passes every segment x has queued to y, and returns the largest payload among them
+static size_t deliver(TCPConnection &x, TCPConnection &y) {
+    size_t largest = 0;
+    while (not x.segments_out().empty()) {
+        const TCPSegment seg = x.segments_out().front();
+        x.segments_out().pop();
+        largest = max(largest, seg.payload().size());
+        y.segment_received(seg);
+    }
+    return largest;
+}
+
+static void run(const size_t x_mss, const size_t y_mss) {
+    TCPConfig x_cfg, y_cfg;
+    x_cfg.mss = x_mss;
+    y_cfg.mss = y_mss;
+    x_cfg.mss_option = y_cfg.mss_option = true;
+    TCPConnection x{x_cfg}, y{y_cfg};
+
+    x.connect();
+    check(x.segments_out().front().header().options.mss == x_mss, "SYN should carry our MSS");
+    deliver(x, y);
+    check(y.segments_out().front().header().options.mss == y_mss, "SYN/ACK should carry our MSS");
+    deliver(y, x);
+
+    // each side sends segments no larger than either MSS, and fills them
+    const size_t mss = min(x_mss, y_mss);
+    x.write(string(3 * mss, 'x'));
+    check(deliver(x, y) == mss, "x should segment to the smaller MSS");
+    y.write(string(3 * mss, 'y'));
+    check(deliver(y, x) == mss, "y should segment to the smaller MSS");
+    check(x.inbound_stream().buffer_size() == 3 * mss and y.inbound_stream().buffer_size() == 3 * mss,
+          "data should arrive");
+
+    x.segments_out() = {};
+    y.segments_out() = {};
+}
+
+// SACK blocks y reports on its data segments never take it past the MSS, while its pure ACKs carry them
+static void run_sack(const size_t mss) {
+    TCPConfig cfg;
+    cfg.mss = mss;
+    cfg.mss_option = cfg.sack = true;
+    TCPConnection x{cfg}, y{cfg};
+    x.connect();
+    deliver(x, y);
+    deliver(y, x);
+    deliver(x, y);
+
+    // x's first segment is lost, so y holds the other two out of order
+    x.write(string(3 * mss, 'x'));
+    x.segments_out().pop();
+    deliver(x, y);
+    check(not y.segments_out().empty() and y.segments_out().back().header().options.num_sack_blocks == 1,
+          "y's ACKs should report the out-of-order data");
+    y.segments_out() = {};
+
+    y.write(string(3 * mss, 'y'));
+    check(not y.segments_out().empty(), "y should send its data");
+    while (not y.segments_out().empty()) {
+        const TCPSegment &seg = y.segments_out().front();
+        check(seg.payload().size() + seg.header().options.length() <= mss, "a data segment shouldn't exceed the MSS");
+        check(seg.header().doff * 4u == TCPHeader::LENGTH + seg.header().options.length(), "wrong data offset");
+        y.segments_out().pop();
+    }
+    x.segments_out() = {};
+}
+
+int main() {
+    try {
+        check(TCPConfig::mss_for_mtu(1500) == 1460, "1500-byte MTU should allow a 1460-byte MSS");
+        run(TCPConfig::mss_for_mtu(1500), TCPConfig::mss_for_mtu(1500));
+        run(TCPConfig::mss_for_mtu(1500), TCPConfig::MAX_PAYLOAD_SIZE);
+        run(536, TCPConfig::mss_for_mtu(9000));
+        run_sack(TCPConfig::mss_for_mtu(1500));
+
+        // without mss_option, a SYN carries no MSS option
+        TCPConnection plain{TCPConfig{}};
+        plain.connect();
+        check(not plain.segments_out().front().header().options.mss, "SYN shouldn't carry an MSS by default");
+        plain.segments_out() = {};
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr unsigned NREPS = 64;
+static constexpr unsigned NSEGS = 512;
+
+// Feed the same random, overlapping, partly out-of-window segments to both backends
+// and check that they agree on every observable after every step.
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            // small, odd capacities exercise wraparound and partial bitmap words
+            const size_t capacity = 1 + rd() % 300;
+            const size_t stream_len = capacity * 8;
+
+            string d(stream_len, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+
+            StreamReassembler map_backend{capacity, StreamReassembler::Backend::IntervalMap};
+            StreamReassembler bitmap_backend{capacity, StreamReassembler::Backend::Bitmap};
+            string map_out, bitmap_out;
+
+            for (unsigned i = 0; i < NSEGS; ++i) {
+                const size_t start = map_backend.stream_out().bytes_written() + rd() % (capacity + 10) -
+                                     min(map_backend.stream_out().bytes_written(), size_t{5});
+                if (start >= stream_len) {
+                    continue;
+                }
+                const size_t len = min(stream_len - start, size_t{rd() % (capacity + 1)});
+                const bool eof = start + len == stream_len;
+
+                map_backend.push_substring(d.substr(start, len), start, eof);
+                bitmap_backend.push_substring(d.substr(start, len), start, eof);
+
+                if (map_backend.unassembled_bytes() != bitmap_backend.unassembled_bytes()) {
+                    throw runtime_error("backends disagree on unassembled_bytes()");
+                }
+                if (map_backend.stream_out().bytes_written() != bitmap_backend.stream_out().bytes_written()) {
+                    throw runtime_error("backends disagree on the number of bytes assembled");
+                }
+                if (map_backend.stream_out().input_ended() != bitmap_backend.stream_out().input_ended()) {
+                    throw runtime_error("backends disagree on EOF");
+                }
+
+                // drain at random so the window keeps moving
+                if (rd() % 2) {
+                    map_out += map_backend.stream_out().read(map_backend.stream_out().buffer_size());
+                    bitmap_out += bitmap_backend.stream_out().read(bitmap_backend.stream_out().buffer_size());
+                }
+            }
+
+            map_out += map_backend.stream_out().read(map_backend.stream_out().buffer_size());
+            bitmap_out += bitmap_backend.stream_out().read(bitmap_backend.stream_out().buffer_size());
+            if (bitmap_out != map_out or bitmap_out != d.substr(0, bitmap_out.size())) {
+                throw runtime_error("Bitmap backend assembled the wrong bytes");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
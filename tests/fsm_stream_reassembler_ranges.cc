@@ -0,0 +1,117 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+using Ranges = vector<pair<uint64_t, uint64_t>>;
+
+static string to_string(const Ranges &ranges) {
+    string s;
+    for (const auto &[start, end] : ranges) {
+        s += "[" + std::to_string(start) + ", " + std::to_string(end) + ") ";
+    }
+    return s.empty() ? "(none)" : s;
+}
+
+static void check_ranges(const StreamReassembler &reassembler,
+                         const size_t max_ranges,
+                         const Ranges &expected,
+                         const string &name) {
+    const Ranges actual = reassembler.unassembled_ranges(max_ranges);
+    if (actual != expected) {
+        throw runtime_error(name + ": expected unassembled ranges " + to_string(expected) + "but got " +
+                            to_string(actual));
+    }
+}
+
+static void run_fixed(const StreamReassembler::Backend backend, const string &name) {
+    StreamReassembler reassembler{16, backend};
+    check_ranges(reassembler, 4, {}, name);
+
+    reassembler.push_substring("cd", 2, false);
+    reassembler.push_substring("gh", 6, false);
+    reassembler.push_substring("kl", 10, false);
+    check_ranges(reassembler, 4, {{2, 4}, {6, 8}, {10, 12}}, name);
+    check_ranges(reassembler, 2, {{2, 4}, {6, 8}}, name);
+    check_ranges(reassembler, 0, {}, name);
+
+    // filling a hole between two ranges merges them
+    reassembler.push_substring("ef", 4, false);
+    check_ranges(reassembler, 4, {{2, 8}, {10, 12}}, name);
+
+    // assembling the front removes it
+    reassembler.push_substring("ab", 0, false);
+    check_ranges(reassembler, 4, {{10, 12}}, name);
+
+    // the window wraps once the stream has been read
+    reassembler.stream_out().read(8);
+    reassembler.push_substring("uvw", 20, false);
+    check_ranges(reassembler, 4, {{10, 12}, {20, 23}}, name);
+
+    reassembler.push_substring("ij", 8, false);
+    check_ranges(reassembler, 4, {{20, 23}}, name);
+}
+
+// Feed random segments to both backends and check that the ranges they report agree
+// and add up to unassembled_bytes().
+static void run_random() {
+    auto rd = get_random_generator();
+    for (unsigned rep_no = 0; rep_no < 64; ++rep_no) {
+        const size_t capacity = 1 + rd() % 300;
+        const size_t stream_len = capacity * 8;
+        const string d(stream_len, 'x');
+
+        StreamReassembler map_backend{capacity, StreamReassembler::Backend::IntervalMap};
+        StreamReassembler bitmap_backend{capacity, StreamReassembler::Backend::Bitmap};
+
+        for (unsigned i = 0; i < 512; ++i) {
+            const size_t start = map_backend.stream_out().bytes_written() + rd() % (capacity + 10);
+            if (start >= stream_len) {
+                continue;
+            }
+            const size_t len = min(stream_len - start, size_t{rd() % (capacity / 4 + 1)});
+            map_backend.push_substring(d.substr(start, len), start, false);
+            bitmap_backend.push_substring(d.substr(start, len), start, false);
+
+            const Ranges ranges = map_backend.unassembled_ranges(SIZE_MAX);
+            check_ranges(bitmap_backend, SIZE_MAX, ranges, "random");
+
+            size_t total = 0;
+            for (const auto &[range_start, range_end] : ranges) {
+                total += range_end - range_start;
+            }
+            if (total != map_backend.unassembled_bytes()) {
+                throw runtime_error("unassembled ranges do not add up to unassembled_bytes()");
+            }
+
+            if (rd() % 2) {
+                map_backend.stream_out().pop_output(map_backend.stream_out().buffer_size());
+                bitmap_backend.stream_out().pop_output(bitmap_backend.stream_out().buffer_size());
+            }
+        }
+    }
+}
+
+int main() {
+    try {
+        run_fixed(StreamReassembler::Backend::IntervalMap, "interval map");
+        run_fixed(StreamReassembler::Backend::Bitmap, "bitmap");
+        run_random();
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+#include "ipv4_header.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+// takes every segment x has queued
+static vector<TCPSegment> take(TCPConnection &x) {
+    vector<TCPSegment> segs;
+    while (not x.segments_out().empty()) {
+        segs.push_back(move(x.segments_out().front()));
+        x.segments_out().pop();
+    }
+    return segs;
+}
+
+// takes the one segment x has queued
+static TCPSegment take_one(TCPConnection &x, const string &what) {
+    vector<TCPSegment> segs = take(x);
+    check(segs.size() == 1, what);
+    return move(segs[0]);
+}
+
+int main() {
+    try {
+        TCPConfig cfg;
+        cfg.timestamps = true;
+        cfg.adaptive_rto = true;
+
+        {
+            TCPConnection x{cfg}, y{cfg};
+            x.tick(7);
+            y.tick(3);
+
+            // both offer timestamps, and the SYN/ACK echoes the SYN's
+            x.connect();
+            const TCPSegment syn = take_one(x, "x should send a SYN");
+            check(syn.header().options.timestamps == TCPTimestamps{7, 0}, "SYN should carry TSval 7");
+            y.segment_received(syn);
+            const TCPSegment syn_ack = take_one(y, "y should send a SYN/ACK");
+            check(syn_ack.header().options.timestamps == TCPTimestamps{3, 7}, "SYN/ACK should echo 7");
+
+            // 100 ms later, the handshake gives x its first RTT sample
+            x.tick(100);
+            x.segment_received(syn_ack);
+            check(x.smoothed_rtt() == 100u, "the handshake should measure 100 ms");
+            const TCPSegment ack = take_one(x, "x should ACK the SYN/ACK");
+            check(ack.header().options.timestamps == TCPTimestamps{107, 3}, "the ACK should echo 3");
+            y.segment_received(ack);
+
+            // a retransmission is timed by the timestamp its ACK echoes (Karn's rule would skip it)
+            x.write("hello");
+            take_one(x, "x should send its data");
+            x.tick(x.retransmission_timeout());
+            const TCPSegment retx = take_one(x, "x should retransmit");
+            x.tick(20);
+            y.segment_received(retx);
+            x.segment_received(take_one(y, "y should ACK the data"));
+            check(x.bytes_in_flight() == 0, "the data should be acknowledged");
+            check(x.smoothed_rtt() == 90u, "the retransmission's 20 ms should be sampled");
+        }
+
+        {
+            TCPConfig plain;
+            TCPConnection x{cfg}, y{plain};
+
+            // without both offering them, no segment carries timestamps
+            x.connect();
+            y.segment_received(take_one(x, "x should send a SYN"));
+            const TCPSegment syn_ack = take_one(y, "y should send a SYN/ACK");
+            check(not syn_ack.header().options.timestamps, "y shouldn't offer timestamps");
+            x.segment_received(syn_ack);
+            y.segment_received(take_one(x, "x should ACK the SYN/ACK"));
+            x.write("hello");
+            check(not take_one(x, "x should send its data").header().options.timestamps, "x shouldn't use timestamps");
+        }
+
+        {
+            TCPConnection x{cfg}, y{cfg};
+            x.connect();
+            y.segment_received(take_one(x, "x should send a SYN"));
+            x.segment_received(take_one(y, "y should send a SYN/ACK"));
+            y.segment_received(take_one(x, "x should ACK the SYN/ACK"));
+
+            x.tick(10);
+            x.write("abc");
+            const TCPSegment first = take_one(x, "x should send abc");
+            y.segment_received(first);
+            check(take_one(y, "y should ACK abc").header().options.timestamps->echo_reply == 10,
+                  "y should echo abc's TSval");
+
+            // a segment at the ackno with an older TSval is an old duplicate whose seqno has
+            // wrapped around into the window: y drops it, but still ACKs
+            x.tick(10);
+            x.write("def");
+            const TCPSegment second = take_one(x, "x should send def");
+            TCPSegment stale = second;
+            stale.header().options.timestamps->value = 9;
+            y.segment_received(stale);
+            check(y.inbound_stream().buffer_size() == 3, "the old duplicate should be dropped");
+            const TCPSegment dup_ack = take_one(y, "y should ACK the old duplicate");
+            check(dup_ack.header().ackno == second.header().seqno, "the ACK shouldn't cover it");
+
+            y.segment_received(second);
+            check(y.inbound_stream().read(6) == "abcdef", "the real segment should be accepted");
+            check(take_one(y, "y should ACK def").header().options.timestamps->echo_reply == 20,
+                  "y should echo def's TSval");
+        }
+
+        {
+            // a segment PAWS drops is only acknowledged: its ackno and window are as stale as its
+            // data, so they mustn't reach the sender
+            TCPConnection x{cfg}, y{cfg};
+            x.connect();
+            y.segment_received(take_one(x, "x should send a SYN"));
+            x.segment_received(take_one(y, "y should send a SYN/ACK"));
+            y.segment_received(take_one(x, "x should ACK the SYN/ACK"));
+
+            x.tick(10);
+            x.write("abc");
+            const TCPSegment abc = take_one(x, "x should send abc");
+            y.segment_received(abc);
+            take(y);
+            y.write("hello");
+            const TCPSegment hello = take_one(y, "y should send hello");
+            y.tick(7);
+
+            // an old duplicate that would acknowledge hello and close the window
+            TCPSegment stale = abc;
+            stale.header().ackno = hello.header().seqno + 5;
+            stale.header().win = 0;
+            stale.header().options.timestamps->value = 5;
+            y.segment_received(stale);
+            const TCPSegment ack = take_one(y, "y should only ACK the old duplicate");
+            check(ack.header().ack and ack.payload().size() == 0, "the reply should be a bare ACK");
+            check(y.bytes_in_flight() == 5, "the stale ackno shouldn't acknowledge hello");
+            check(y.time_since_last_segment_received() == 7, "the old duplicate shouldn't count as heard from");
+            y.write("more");
+            check(take_one(y, "the stale window shouldn't hold y back").payload().size() == 4, "y should send more");
+        }
+
+        {
+            // with delayed ACKs, the echo is the TSval of the oldest segment the ACK covers: one
+            // that arrives beyond the last ackno sent doesn't replace it (Last.ACK.sent)
+            TCPConfig delayed = cfg;
+            delayed.delayed_ack = true;
+            TCPConnection x{delayed}, y{delayed};
+            x.connect();
+            y.segment_received(take_one(x, "x should send a SYN"));
+            x.segment_received(take_one(y, "y should send a SYN/ACK"));
+            y.segment_received(take_one(x, "x should ACK the SYN/ACK"));
+
+            x.tick(10);
+            x.write("abc");
+            y.segment_received(take_one(x, "x should send abc"));
+            x.tick(10);
+            x.write("def");
+            y.segment_received(take_one(x, "x should send def"));
+            check(y.segments_out().empty(), "y should delay its ACK");
+            y.tick(TCPConfig::DELACK_DFLT);
+            const TCPSegment ack = take_one(y, "y should ACK both");
+            check(ack.header().options.timestamps->echo_reply == 10, "y should echo abc's TSval, not def's");
+        }
+
+        {
+            // full-sized segments leave room for the timestamps, so they still fit a 1500-byte MTU
+            TCPConfig ethernet = cfg;
+            ethernet.mss = TCPConfig::mss_for_mtu(1500);
+            ethernet.mss_option = ethernet.sack = true;
+            TCPConnection x{ethernet}, y{ethernet};
+            x.connect();
+            y.segment_received(take_one(x, "x should send a SYN"));
+            x.segment_received(take_one(y, "y should send a SYN/ACK"));
+            y.segment_received(take_one(x, "x should ACK the SYN/ACK"));
+
+            x.write(string(3 * ethernet.mss, 'x'));
+            const vector<TCPSegment> segs = take(x);
+            check(segs.size() == 4, "x should send four segments");
+            for (const TCPSegment &seg : segs) {
+                check(seg.header().options.timestamps.has_value(), "every segment should carry timestamps");
+                const size_t headers = IPv4Header::LENGTH + TCPHeader::LENGTH + seg.header().options.length();
+                check(headers + seg.payload().size() <= 1500, "a segment shouldn't outgrow the MTU");
+            }
+            check(segs[0].payload().size() == ethernet.mss - TCPOptions::TIMESTAMPS_SPACE,
+                  "a full segment should fill the MSS, less the timestamps");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
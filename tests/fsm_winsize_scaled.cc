@@ -0,0 +1,78 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+// passes every segment x has queued to y, and returns the last one
+static TCPSegment deliver(TCPConnection &x, TCPConnection &y) {
+    check(not x.segments_out().empty(), "expected a segment");
+    TCPSegment last;
+    while (not x.segments_out().empty()) {
+        last = x.segments_out().front();
+        x.segments_out().pop();
+        y.segment_received(last);
+    }
+    return last;
+}
+
+static void run(const bool x_scales, const bool y_scales) {
+    constexpr size_t capacity = 1 << 20;
+    TCPConfig x_cfg, y_cfg;
+    x_cfg.recv_capacity = x_cfg.send_capacity = y_cfg.recv_capacity = y_cfg.send_capacity = capacity;
+    x_cfg.window_scaling = x_scales;
+    y_cfg.window_scaling = y_scales;
+
+    TCPConnection x{x_cfg}, y{y_cfg};
+    const uint8_t shift = TCPConfig::window_shift(capacity);
+    check(shift == 5, "1 MiB should need a shift of 5");
+
+    x.connect();
+    const TCPSegment syn = deliver(x, y);
+    check(syn.header().options.window_scale == (x_scales ? optional<uint8_t>{shift} : nullopt), "SYN option");
+    check(syn.header().win == UINT16_MAX, "the window in a SYN is never scaled");
+
+    const TCPSegment syn_ack = deliver(y, x);
+    const bool agreed = x_scales and y_scales;
+    check(syn_ack.header().options.window_scale == (agreed ? optional<uint8_t>{shift} : nullopt),
+          "a SYN/ACK must only offer window scaling if the SYN did");
+
+    // the next ACK from x advertises its window scaled down
+    x.write(string(1, 'a'));
+    const TCPSegment ack = deliver(x, y);
+    check(ack.header().win == (agreed ? capacity >> shift : UINT16_MAX), "advertised window");
+    deliver(y, x);
+
+    // and x can have more than 64 KiB in flight only if y's windows are scaled
+    x.write(string(capacity / 2, 'b'));
+    check(x.bytes_in_flight() == (agreed ? capacity / 2 : UINT16_MAX), "bytes in flight");
+
+    x.segments_out() = {};
+    y.segments_out() = {};
+}
+
+int main() {
+    try {
+        run(true, true);
+        run(true, false);
+        run(false, true);
+        run(false, false);
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
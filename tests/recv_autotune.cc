@@ -0,0 +1,160 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+static TCPSegment segment(const uint32_t seqno, const string &data, const bool syn = false) {
+    TCPSegment seg;
+    seg.header().seqno = WrappingInt32{seqno};
+    seg.header().syn = syn;
+    seg.payload() = string(data);
+    return seg;
+}
+
+// the sender fills the receiver's window, in segments of up to 500 bytes
+static string fill_window(TCPReceiver &receiver, uint64_t &sent) {
+    string data;
+    const size_t window = receiver.window_size();
+    while (data.size() < window) {
+        string chunk;
+        for (size_t i = 0; i < min<size_t>(500, window - data.size()); i++) {
+            chunk.push_back(static_cast<char>('a' + (sent + data.size() + i) % 26));
+        }
+        receiver.segment_received(segment(static_cast<uint32_t>(1 + sent + data.size()), chunk));
+        data += chunk;
+    }
+    sent += data.size();
+    return data;
+}
+
+int main() {
+    try {
+        {
+            // a reader that keeps up lets the capacity double each RTT, up to the maximum
+            TCPReceiver receiver{1000, StreamReassembler::Backend::IntervalMap, 8000};
+            receiver.segment_received(segment(0, "", true));
+            uint64_t sent = 0;
+            for (const size_t expected : {2000, 4000, 8000, 8000}) {
+                const string data = fill_window(receiver, sent);
+                check(receiver.stream_out().read(data.size()) == data, "the data should arrive intact");
+                receiver.tick(50, 50);
+                check(receiver.capacity() == expected, "capacity should be " + to_string(expected));
+                check(receiver.window_size() == expected, "the window should open to the new capacity");
+            }
+
+            // idling with data still buffered keeps the memory; once it is read, it is given back
+            receiver.segment_received(segment(static_cast<uint32_t>(1 + sent), "xyz"));
+            receiver.tick(TCPReceiver::AUTOTUNE_IDLE, 50);
+            check(receiver.capacity() == 8000, "capacity shouldn't shrink under buffered data");
+            check(receiver.stream_out().read(3) == "xyz", "the buffered data should survive");
+            receiver.tick(1, 50);
+            check(receiver.capacity() == 1000, "capacity should shrink back when idle");
+            check(receiver.window_size() == 1000, "the window should shrink with it");
+        }
+
+        {
+            // once a larger window has been advertised, shrinking doesn't pull back its right edge
+            TCPReceiver receiver{1000, StreamReassembler::Backend::Bitmap, 8000};
+            receiver.segment_received(segment(0, "", true));
+            uint64_t sent = 0;
+            for (unsigned round = 0; round < 3; round++) {
+                const string data = fill_window(receiver, sent);
+                receiver.stream_out().read(data.size());
+                receiver.tick(50, 50);
+            }
+            check(receiver.capacity() == 8000, "capacity should have grown");
+            receiver.ack_sent(receiver.ackno().value(), receiver.window_size());
+
+            receiver.tick(TCPReceiver::AUTOTUNE_IDLE, 50);
+            check(receiver.capacity() == 1000, "capacity should shrink back when idle");
+            check(receiver.window_size() == 8000, "the window should still reach the edge advertised");
+
+            // the peer may still fill the window it saw, and once the reader has caught up with
+            // that edge, the memory is given back
+            const string data = fill_window(receiver, sent);
+            check(data.size() == 8000 and receiver.stream_out().buffer_size() == 8000, "the data should be kept");
+            receiver.ack_sent(receiver.ackno().value(), receiver.window_size());
+            check(receiver.window_size() == 0, "a full buffer should close the window");
+            check(receiver.stream_out().read(8000) == data, "the data should arrive intact");
+            check(receiver.window_size() == 1000, "the window should reopen only to the new capacity");
+            receiver.ack_sent(receiver.ackno().value(), receiver.window_size());
+            receiver.tick(1, 50);
+            check(receiver.stream_out().remaining_capacity() == 1000, "the memory should be given back");
+            check(receiver.window_size() == 1000, "the window should stay at the new capacity");
+        }
+
+        {
+            // a slow reader, without an RTT estimate: the reader is the bottleneck, so no growth
+            TCPReceiver receiver{1000, StreamReassembler::Backend::Bitmap, 8000};
+            receiver.segment_received(segment(0, "", true));
+            uint64_t sent = 0;
+            for (unsigned round = 0; round < 10; round++) {
+                fill_window(receiver, sent);
+                receiver.stream_out().pop_output(300);
+                receiver.tick(TCPReceiver::AUTOTUNE_INTERVAL_DFLT);
+                check(receiver.capacity() == 1000, "a slow reader shouldn't grow the capacity");
+            }
+        }
+
+        {
+            // without a maximum above the capacity, auto-tuning is off
+            TCPReceiver receiver{1000};
+            receiver.segment_received(segment(0, "", true));
+            uint64_t sent = 0;
+            receiver.stream_out().pop_output(fill_window(receiver, sent).size());
+            receiver.tick(1000, 10);
+            check(receiver.capacity() == 1000, "capacity shouldn't change without auto-tuning");
+        }
+
+        for (const auto backend : {StreamReassembler::Backend::IntervalMap, StreamReassembler::Backend::Bitmap}) {
+            // resizing keeps out-of-order bytes, including ones that wrapped around a ring
+            StreamReassembler reassembler{8, backend};
+            reassembler.push_substring("ab", 0, false);
+            check(reassembler.stream_out().read(2) == "ab", "ab should be reassembled");
+            reassembler.push_substring("ghij", 6, false);
+            check(reassembler.set_capacity(16) == 16, "the capacity should grow");
+            reassembler.push_substring("klmnopqr", 10, false);
+            check(reassembler.unassembled_bytes() == 12, "the grown window should take more bytes");
+
+            // never shrinks below the bytes stored (up to index 18, with 2 read)
+            check(reassembler.set_capacity(4) == 16, "the capacity can't drop below what is stored");
+            reassembler.push_substring("cdef", 2, false);
+            check(reassembler.stream_out().read(16) == "cdefghijklmnopqr", "the stream should be intact");
+            check(reassembler.set_capacity(4) == 4, "an empty reassembler can shrink");
+            check(reassembler.stream_out().remaining_capacity() == 4, "the stream should shrink with it");
+        }
+
+        {
+            // a contiguous ByteStream whose bytes wrap around keeps them in order when resized
+            ByteStream stream{6};
+            stream.write("abcd");
+            stream.pop_output(3);
+            stream.write("efgh");
+            check(stream.set_capacity(2) == 5, "the stream can't drop below its buffered bytes");
+            check(stream.set_capacity(10) == 10, "the stream should grow");
+            stream.write("ijklm");
+            check(stream.read(10) == "defghijklm", "the bytes should stay in order");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
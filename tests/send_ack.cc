@@ -65,6 +65,29 @@ int main() {
             test.execute(ExpectState{TCPSenderStateSummary::SYN_SENT});
         }
 
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(UINT32_MAX - 1500);
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"ACKs work across the sequence number wraparound", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            test.execute(WriteBytes{string(3000, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(ExpectBytesInFlight{3000});
+
+            // the second segment straddles the wraparound, and the third starts past it
+            test.execute(AckReceived{WrappingInt32{isn + 2001}}.with_win(5000));
+            test.execute(ExpectBytesInFlight{1000});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(AckReceived{WrappingInt32{isn + 3001}}.with_win(5000));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
         /* remove requirement to send corrective ACK for bad ACK
             {
                 TCPConfig cfg;
@@ -0,0 +1,148 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"The congestion window limits what is sent, and grows with ACKs", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(ExpectCongestionWindow{10 * mss + 1});
+
+            // the receiver would take 20 segments, but only 10 fit in the initial window
+            test.execute(WriteBytes{string(20 * mss, 'x')});
+            for (unsigned i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // slow start: acknowledging one segment lets two more go
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(64000));
+            test.execute(ExpectCongestionWindow{11 * mss + 1});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 10 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 11 * mss));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"A timeout restarts slow start from one segment", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{string(20 * mss, 'x')});
+            for (unsigned i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{mss});
+
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * mss}}.with_win(64000));
+            test.execute(ExpectCongestionWindow{3 * mss});
+            for (unsigned i = 10; i < 13; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"A loss found through SACK halves the window once per window of data", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{string(20 * mss, 'x')});
+            for (unsigned i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            test.execute(
+                AckReceived{WrappingInt32{isn + 1}}.with_win(64000).with_sack(isn + 1 + mss, isn + 1 + 4 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{5 * mss});
+
+            // more SACKs for the same window don't shrink it again
+            test.execute(
+                AckReceived{WrappingInt32{isn + 1}}.with_win(64000).with_sack(isn + 1 + mss, isn + 1 + 6 * mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{5 * mss});
+
+            // once recovered, congestion avoidance adds a segment per window acknowledged
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * mss}}.with_win(64000));
+            test.execute(ExpectCongestionWindow{6 * mss});
+            for (unsigned i = 10; i < 16; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC keeps 70% of the window after a loss", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{string(20 * mss, 'x')});
+            for (unsigned i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            test.execute(
+                AckReceived{WrappingInt32{isn + 1}}.with_win(64000).with_sack(isn + 1 + mss, isn + 1 + 4 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{7 * mss});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without congestion control, only the receiver's window limits the sender", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(ExpectCongestionWindow{UINT64_MAX});
+            test.execute(WriteBytes{string(20 * mss, 'x')});
+            for (unsigned i = 0; i < 20; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without fast retransmit, duplicate ACKs are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{string(4 * mss, 'x')});
+            for (unsigned i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            for (unsigned i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Three duplicate ACKs retransmit the oldest segment, and partial ACKs the next",
+                                      cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{string(10 * mss, 'x')});
+            for (unsigned i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            // segments 0 and 5 were lost
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(ExpectNoSegment{});
+
+            // the retransmission fills the first hole, and the ACK shows the second
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * mss}}.with_win(64000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 5 * mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * mss}}.with_win(64000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"An ACK with a new window, or after a timeout, doesn't count as a duplicate", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{string(4 * mss, 'x')});
+            for (unsigned i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(63000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(63000));
+            test.execute(ExpectNoSegment{});
+
+            // the timeout's retransmission is all there is until the ACK moves past what was sent
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            for (unsigned i = 0; i < 4; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(63000));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"Fast recovery halves the window once, and keeps new data flowing", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{string(20 * mss, 'x')});
+            for (unsigned i = 0; i < 10; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            // the first segment was lost: the window halves to 5 segments, plus the 3 that left
+            for (unsigned i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{5 * mss});
+
+            // each further duplicate lets another segment go, once 10 are no longer in flight
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 10 * mss));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 11 * mss));
+            test.execute(ExpectNoSegment{});
+
+            // the ACK for everything sent before the loss ends recovery, and the window goes back to
+            // the halved one (plus a segment of congestion avoidance for the window acknowledged)
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * mss}}.with_win(64000));
+            test.execute(ExpectCongestionWindow{6 * mss});
+            for (unsigned i = 12; i < 16; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
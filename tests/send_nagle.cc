@@ -0,0 +1,104 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without Nagle, every small write is sent right away", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            for (unsigned i = 0; i < 3; i++) {
+                test.execute(WriteBytes{"ab"});
+                test.execute(ExpectSegment{}.with_payload_size(2).with_data("ab").with_seqno(isn + 1 + 2 * i));
+            }
+            test.execute(ExpectBytesInFlight{6});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"With Nagle, small writes wait for the ACK and go out together", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+
+            // nothing is in flight, so the first small write goes at once
+            test.execute(WriteBytes{"ab"});
+            test.execute(ExpectSegment{}.with_payload_size(2).with_data("ab").with_seqno(isn + 1));
+            test.execute(WriteBytes{"cd"});
+            test.execute(WriteBytes{"ef"});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectNoSegment{});
+
+            // the ACK releases everything written meanwhile as one segment
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(64000));
+            test.execute(ExpectSegment{}.with_payload_size(4).with_data("cdef").with_seqno(isn + 3));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"With Nagle, full segments still go while data is in flight", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{"x"});
+            test.execute(ExpectSegment{}.with_payload_size(1).with_seqno(isn + 1));
+
+            // two full segments leave, and the short tail waits
+            test.execute(WriteBytes{string(2 * mss + 10, 'y')});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 2));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 2 + mss));
+            test.execute(ExpectNoSegment{});
+
+            // an ACK for only some of it doesn't release the tail
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(64000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 2 + 2 * mss}}.with_win(64000));
+            test.execute(ExpectSegment{}.with_payload_size(10).with_seqno(isn + 2 + 2 * mss));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.nagle = true;
+
+            TCPSenderTestHarness test{"With Nagle, the end of the stream isn't held back", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(64000));
+            test.execute(WriteBytes{"ab"});
+            test.execute(ExpectSegment{}.with_payload_size(2).with_seqno(isn + 1));
+            test.execute(WriteBytes{"cd"}.with_end_input(true));
+            test.execute(ExpectSegment{}.with_fin(true).with_payload_size(2).with_data("cd").with_seqno(isn + 3));
+            test.execute(ExpectBytesInFlight{5});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"SRTT and RTO follow the RTT samples", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectSrtt{nullopt});
+            test.execute(ExpectRto{cfg.rt_timeout});
+
+            // first sample: SRTT = 100, RTTVAR = 50, RTO = 100 + 4 * 50
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSrtt{100});
+            test.execute(ExpectRto{300});
+
+            // second sample: RTTVAR = 3/4 * 50 + 1/4 * 50, SRTT = 7/8 * 100 + 1/8 * 50
+            test.execute(WriteBytes{string(100, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(100).with_seqno(isn + 1));
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 101}}.with_win(1000));
+            test.execute(ExpectSrtt{93});
+            test.execute(ExpectRto{293});
+
+            // the new RTO is the one the timer uses
+            test.execute(WriteBytes{string(100, 'y')});
+            test.execute(ExpectSegment{}.with_payload_size(100).with_seqno(isn + 101));
+            test.execute(Tick{292});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(100).with_seqno(isn + 101));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"A short RTT is clamped to the minimum RTO", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSrtt{10});
+            test.execute(ExpectRto{TCPConfig::MIN_RTO_DFLT});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.min_rto = 500;
+            cfg.max_rto = 300;
+
+            TCPSenderTestHarness test{"With the bounds crossed, the maximum RTO wins", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRto{300});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.max_rto = 3000;
+
+            TCPSenderTestHarness test{"Back-off stops at the maximum RTO", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn}}.with_win(1000));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(ExpectRto{2u * cfg.rt_timeout});
+            test.execute(Tick{2u * cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(ExpectRto{3000});
+            test.execute(Tick{3000});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(ExpectRto{3000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.max_rto = 3000;
+
+            TCPSenderTestHarness test{"Without adaptive RTO, back-off stops at the maximum RTO too", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn}}.with_win(1000));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(ExpectRto{2u * cfg.rt_timeout});
+            test.execute(Tick{2u * cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(ExpectRto{3000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"Retransmitted segments are not timed (Karn's rule)", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSrtt{nullopt});
+            test.execute(ExpectRto{cfg.rt_timeout});
+
+            // the next segment sent is timed again
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectSrtt{40});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without adaptive RTO, the RTT is measured but the RTO stays put", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSrtt{100});
+            test.execute(ExpectRto{cfg.rt_timeout});
+
+            // and Karn's rule still applies
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_seqno(isn + 1));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectSrtt{100});
+            test.execute(ExpectRto{cfg.rt_timeout});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Hole is retransmitted once enough data above it is SACKed", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(6 * mss));
+            test.execute(WriteBytes{string(6 * mss, 'x')});
+            for (unsigned i = 0; i < 6; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // two segments above the hole could just be reordering
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(6 * mss).with_sack(isn + 1 + mss,
+                                                                                         isn + 1 + 3 * mss));
+            test.execute(ExpectNoSegment{});
+
+            // the third one means it was lost
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(6 * mss).with_sack(isn + 1 + mss,
+                                                                                         isn + 1 + 4 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // it is only retransmitted once
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(6 * mss).with_sack(isn + 1 + mss,
+                                                                                         isn + 1 + 5 * mss));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{6 * mss});
+
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * mss}}.with_win(6 * mss));
+            test.execute(ExpectBytesInFlight{mss});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Several holes are retransmitted together, lowest first", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(8 * mss));
+            test.execute(WriteBytes{string(8 * mss, 'x')});
+            for (unsigned i = 0; i < 8; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            // segments 1 and 3 are missing; the blocks arrive out of order
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}
+                             .with_win(8 * mss)
+                             .with_sack(isn + 1 + 4 * mss, isn + 1 + 8 * mss)
+                             .with_sack(isn + 1 + 2 * mss, isn + 1 + 3 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 3 * mss));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Bogus SACK blocks are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(4 * mss));
+            test.execute(WriteBytes{string(4 * mss, 'x')});
+            for (unsigned i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            // beyond what was sent, below the ackno, and backwards
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(4 * mss)
+                             .with_sack(isn + 1 + 2 * mss, isn + 1 + 9 * mss)
+                             .with_sack(isn - 3 * mss, isn)
+                             .with_sack(isn + 1 + 4 * mss, isn + 1 + mss));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
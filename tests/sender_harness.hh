@@ -9,6 +9,7 @@
 #include "wrapping_integers.hh"
 
 #include <algorithm>
+#include <array>
 #include <deque>
 #include <exception>
 #include <iostream>
@@ -20,7 +21,7 @@ const unsigned int DEFAULT_TEST_WINDOW = 137;
 
 struct SenderTestStep {
     virtual operator std::string() const { return "SenderTestStep"; }
-    virtual void execute(TCPSender &, std::queue<TCPSegment> &) const {}
+    virtual void execute(TCPSender &, SegmentQueue &) const {}
     virtual ~SenderTestStep() {}
 };
 
@@ -50,7 +51,7 @@ class SegmentExpectationViolation : public SenderExpectationViolation {
 struct SenderExpectation : public SenderTestStep {
     operator std::string() const { return "Expectation: " + description(); }
     virtual std::string description() const { return "description missing"; }
-    virtual void execute(TCPSender &, std::queue<TCPSegment> &) const {}
+    virtual void execute(TCPSender &, SegmentQueue &) const {}
     virtual ~SenderExpectation() {}
 };
 
@@ -59,7 +60,7 @@ struct ExpectState : public SenderExpectation {
 
     ExpectState(const std::string &state) : _state(state) {}
     std::string description() const { return "in state `" + _state + "`"; }
-    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+    void execute(TCPSender &sender, SegmentQueue &) const {
         if (TCPState::state_summary(sender) != _state) {
             throw SenderExpectationViolation("The TCPSender was in state `" + TCPState::state_summary(sender) +
                                              "`, but it was expected to be in state `" + _state + "`");
@@ -73,7 +74,7 @@ struct ExpectSeqno : public SenderExpectation {
     ExpectSeqno(WrappingInt32 seqno) : _seqno(seqno) {}
     std::string description() const { return "next seqno " + std::to_string(_seqno.raw_value()); }
 
-    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+    void execute(TCPSender &sender, SegmentQueue &) const {
         if (sender.next_seqno() != _seqno) {
             std::string reported = std::to_string(sender.next_seqno().raw_value());
             std::string expected = to_string(_seqno);
@@ -89,7 +90,7 @@ struct ExpectBytesInFlight : public SenderExpectation {
     ExpectBytesInFlight(size_t n_bytes) : _n_bytes(n_bytes) {}
     std::string description() const { return std::to_string(_n_bytes) + " bytes in flight"; }
 
-    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+    void execute(TCPSender &sender, SegmentQueue &) const {
         if (sender.bytes_in_flight() != _n_bytes) {
             std::ostringstream ss;
             ss << "The TCPSender reported " << sender.bytes_in_flight()
@@ -99,11 +100,62 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectRto : public SenderExpectation {
+    unsigned int _rto;
+
+    ExpectRto(unsigned int rto) : _rto(rto) {}
+    std::string description() const { return "retransmission timeout of " + std::to_string(_rto) + "ms"; }
+
+    void execute(TCPSender &sender, SegmentQueue &) const {
+        if (sender.retransmission_timeout() != _rto) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a retransmission timeout of " << sender.retransmission_timeout()
+               << "ms, but it was expected to be " << _rto << "ms";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectCongestionWindow : public SenderExpectation {
+    uint64_t _cwnd;
+
+    ExpectCongestionWindow(uint64_t cwnd) : _cwnd(cwnd) {}
+    std::string description() const { return "congestion window of " + std::to_string(_cwnd) + " bytes"; }
+
+    void execute(TCPSender &sender, SegmentQueue &) const {
+        if (sender.congestion_window() != _cwnd) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a congestion window of " << sender.congestion_window()
+               << " bytes, but it was expected to be " << _cwnd << " bytes";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectSrtt : public SenderExpectation {
+    std::optional<uint64_t> _srtt;
+
+    ExpectSrtt(std::optional<uint64_t> srtt) : _srtt(srtt) {}
+    std::string description() const {
+        return _srtt ? "smoothed RTT of " + std::to_string(*_srtt) + "ms" : "no RTT measured";
+    }
+
+    void execute(TCPSender &sender, SegmentQueue &) const {
+        if (sender.smoothed_rtt() != _srtt) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a smoothed RTT of "
+               << (sender.smoothed_rtt() ? std::to_string(*sender.smoothed_rtt()) + "ms" : "(none)")
+               << ", but it was expected to be " << (_srtt ? std::to_string(*_srtt) + "ms" : "(none)");
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
 
-    void execute(TCPSender &, std::queue<TCPSegment> &segments) const {
+    void execute(TCPSender &, SegmentQueue &segments) const {
         if (not segments.empty()) {
             std::ostringstream ss;
             ss << "The TCPSender sent a segment, but should not have. Segment info:\n\t";
@@ -118,7 +170,7 @@ struct ExpectNoSegment : public SenderExpectation {
 struct SenderAction : public SenderTestStep {
     operator std::string() const { return "Action:      " + description(); }
     virtual std::string description() const { return "description missing"; }
-    virtual void execute(TCPSender &, std::queue<TCPSegment> &) const {}
+    virtual void execute(TCPSender &, SegmentQueue &) const {}
     virtual ~SenderAction() {}
 };
 
@@ -136,7 +188,7 @@ struct WriteBytes : public SenderAction {
         return ss.str();
     }
 
-    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+    void execute(TCPSender &sender, SegmentQueue &) const {
         sender.stream_in().write(std::move(_bytes));
         if (_end_input) {
             sender.stream_in().end_input();
@@ -170,7 +222,7 @@ struct Tick : public SenderAction {
         return ss.str();
     }
 
-    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+    void execute(TCPSender &sender, SegmentQueue &) const {
         sender.tick(_ms);
         if (max_retx_exceeded.has_value() and
             max_retx_exceeded != (sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS)) {
@@ -191,11 +243,16 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::array<TCPSackBlock, TCPOptions::MAX_SACK_BLOCKS> _sack_blocks{};
+    size_t _num_sack_blocks{0};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (size_t i = 0; i < _num_sack_blocks; i++) {
+            ss << " sack [" << _sack_blocks[i].left.raw_value() << ", " << _sack_blocks[i].right.raw_value() << ")";
+        }
         return ss.str();
     }
 
@@ -204,8 +261,16 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
-    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        _sack_blocks.at(_num_sack_blocks++) = TCPSackBlock{left, right};
+        return *this;
+    }
+
+    void execute(TCPSender &sender, SegmentQueue &) const {
         sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        if (_num_sack_blocks > 0) {
+            sender.sack_received(_sack_blocks, _num_sack_blocks);
+        }
         sender.fill_window();
     }
 };
@@ -214,7 +279,7 @@ struct Close : public SenderAction {
     Close() {}
     std::string description() const { return "close"; }
 
-    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+    void execute(TCPSender &sender, SegmentQueue &) const {
         sender.stream_in().end_input();
         sender.fill_window();
     }
@@ -336,7 +401,7 @@ struct ExpectSegment : public SenderExpectation {
 
     virtual std::string description() const { return "segment sent with " + segment_description(); }
 
-    void execute(TCPSender &, std::queue<TCPSegment> &segments) const {
+    void execute(TCPSender &, SegmentQueue &segments) const {
         if (segments.empty()) {
             throw SegmentExpectationViolation::violated_verb("existed");
         }
@@ -379,7 +444,7 @@ struct ExpectSegment : public SenderExpectation {
 };
 
 class TCPSenderTestHarness {
-    std::queue<TCPSegment> outbound_segments;
+    SegmentQueue outbound_segments;
     TCPSender sender;
     std::vector<std::string> steps_executed;
     std::string name;
@@ -394,7 +459,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -0,0 +1,187 @@
+#include "address.hh"
+#include "buffer.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+#include "tcp_state.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+// moves one engine's datagrams to the other, through their wire format; `drop` may discard some
+static size_t deliver(TCPEngine &from, TCPEngine &to, const function<bool(const InternetDatagram &)> &drop) {
+    size_t delivered = 0;
+    auto &queue = from.datagrams_out();
+    while (not queue.empty()) {
+        InternetDatagram dgram;
+        check(dgram.parse(Buffer(queue.front().serialize().concatenate())) == ParseResult::NoError,
+              "the engine should send valid datagrams");
+        queue.pop();
+        if (not drop(dgram)) {
+            to.datagram_received(dgram);
+            delivered++;
+        }
+    }
+    return delivered;
+}
+
+// trades datagrams until both engines are quiet
+static void exchange(TCPEngine &a, TCPEngine &b, const function<bool(const InternetDatagram &)> &drop = {}) {
+    const auto keep = [&](const InternetDatagram &dgram) { return drop and drop(dgram); };
+    while (deliver(a, b, keep) + deliver(b, a, keep) > 0) {
+    }
+}
+
+static void advance(TCPEngine &a, TCPEngine &b, const uint64_t now) {
+    a.advance(now);
+    b.advance(now);
+}
+
+static const Address CLIENT{"10.0.0.1"};
+static const Address SERVER{"10.0.0.2", 80};
+
+static Address client_port(const uint16_t port) { return {CLIENT.ip(), port}; }
+
+int main() {
+    try {
+        const TCPConfig cfg{};
+        const uint64_t rto = cfg.rt_timeout;
+
+        {
+            // many connections share the engines, and each gets its own data, in both directions
+            constexpr size_t N = 1000;
+            TCPEngine client, server;
+            server.listen(cfg, {"0.0.0.0", SERVER.port()}, N);
+
+            vector<TCPEngine::ConnectionId> outbound;
+            for (size_t i = 0; i < N; i++) {
+                outbound.push_back(client.connect(cfg, client_port(static_cast<uint16_t>(10000 + i)), SERVER));
+            }
+            exchange(client, server);
+
+            vector<TCPEngine::ConnectionId> inbound;
+            while (const auto id = server.accept(SERVER.port())) {
+                inbound.push_back(*id);
+            }
+            check(inbound.size() == N, "every connection should be in the accept queue");
+            check(server.size() == N and client.size() == N, "each engine should hold every connection");
+
+            for (const TCPEngine::ConnectionId id : inbound) {
+                const uint16_t port = server.four_tuple(id).remote_port;
+                check(server.connection(id).state() == TCPState::State::ESTABLISHED, "accepted, so established");
+                server.write(id, "reply to " + to_string(port));
+            }
+            for (size_t i = 0; i < N; i++) {
+                check(client.connection(outbound[i]).state() == TCPState::State::ESTABLISHED,
+                      "the client side should be established");
+                client.write(outbound[i], "hello from " + to_string(10000 + i));
+            }
+            exchange(client, server);
+
+            for (size_t i = 0; i < N; i++) {
+                const string expected = "reply to " + to_string(10000 + i);
+                check(client.connection(outbound[i]).inbound_stream().read(100) == expected,
+                      "the client should read its own reply");
+            }
+            for (const TCPEngine::ConnectionId id : inbound) {
+                const string expected = "hello from " + to_string(server.four_tuple(id).remote_port);
+                check(server.connection(id).inbound_stream().read(100) == expected,
+                      "the server should read each client's data on its own connection");
+            }
+
+            // the client closes first, so the server's side goes once its FIN is acknowledged,
+            // and the client's once it has lingered
+            for (const TCPEngine::ConnectionId id : outbound) {
+                client.release(id);
+            }
+            exchange(client, server);
+            for (const TCPEngine::ConnectionId id : inbound) {
+                server.release(id);
+            }
+            exchange(client, server);
+            check(server.size() == 0, "the server should have removed its connections");
+            check(client.size() == N, "the client should linger");
+            check(client.next_deadline().has_value(), "lingering connections should have a deadline");
+
+            advance(client, server, 10 * rto);
+            exchange(client, server);
+            check(client.size() == 0, "the client's connections should go after lingering");
+            check(not client.next_deadline().has_value(), "no deadlines should remain");
+        }
+
+        {
+            // a full backlog drops SYNs, and the client's retransmission gets in once there is room
+            TCPEngine client, server;
+            server.listen(cfg, SERVER, 2);
+            vector<TCPEngine::ConnectionId> outbound;
+            for (uint16_t port = 20000; port < 20003; port++) {
+                outbound.push_back(client.connect(cfg, client_port(port), SERVER));
+            }
+            exchange(client, server);
+            check(server.size() == 2, "the backlog should hold two connections");
+            check(server.dropped() == 1, "the third SYN should be dropped");
+            check(client.connection(outbound[2]).state() == TCPState::State::SYN_SENT,
+                  "the third connection should still be trying");
+
+            const auto first = server.accept(SERVER.port());
+            check(first.has_value() and server.four_tuple(*first).remote_port == 20000, "accept() should be FIFO");
+
+            advance(client, server, rto);
+            exchange(client, server);
+            check(server.accept(SERVER.port()).has_value(), "the second connection should be queued");
+            const auto third = server.accept(SERVER.port());
+            check(third.has_value() and server.four_tuple(*third).remote_port == 20002,
+                  "the retransmitted SYN should have been accepted");
+            check(not server.accept(SERVER.port()).has_value(), "the queue should be empty");
+
+            // a lost datagram is retransmitted when the engine's clock reaches the connection's deadline
+            client.write(outbound[2], "lost once");
+            exchange(client, server, [](const InternetDatagram &dgram) { return dgram.payload().size() > 20; });
+            check(server.connection(*third).inbound_stream().buffer_empty(), "the data should have been lost");
+            advance(client, server, 2 * rto);
+            exchange(client, server);
+            check(server.connection(*third).inbound_stream().read(100) == "lost once",
+                  "the data should arrive after the retransmission");
+        }
+
+        {
+            // a segment for no connection or listener is answered with a RST
+            TCPEngine client, server;
+            server.listen(cfg, SERVER);
+            const auto id = client.connect(cfg, client_port(30000), {SERVER.ip(), 81});
+            exchange(client, server);
+            check(server.size() == 0 and server.dropped() == 1, "the server shouldn't take the SYN");
+            check(not client.connection(id).active(), "the RST should reset the connection");
+            check(client.connection(id).inbound_stream().error(), "the reset should be reported");
+
+            // connecting twice on the same four-tuple isn't allowed
+            client.connect(cfg, client_port(30001), SERVER);
+            bool threw = false;
+            try {
+                client.connect(cfg, client_port(30001), SERVER);
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            check(threw, "a four-tuple should only have one connection");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
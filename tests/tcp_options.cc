@@ -0,0 +1,114 @@
+#include "parser.hh"
+#include "tcp_header.hh"
+#include "tcp_options.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static TCPHeader parse_header(const string &bytes) {
+    TCPHeader header;
+    NetParser p{Buffer(string(bytes))};
+    if (const auto res = header.parse(p); res != ParseResult::NoError) {
+        throw runtime_error("header failed to parse: " + as_string(res));
+    }
+    return header;
+}
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+int main() {
+    try {
+        // every decoded option at once fills the 40 bytes of option space
+        {
+            TCPHeader header;
+            header.seqno = WrappingInt32{12345};
+            header.syn = true;
+            header.options.mss = 1460;
+            header.options.window_scale = 7;
+            header.options.sack_permitted = true;
+            header.options.timestamps = TCPTimestamps{0xdeadbeef, 42};
+            header.options.num_sack_blocks = 2;
+            header.options.sack_blocks[0] = {WrappingInt32{100}, WrappingInt32{200}};
+            header.options.sack_blocks[1] = {WrappingInt32{300}, WrappingInt32{400}};
+            check(header.options.length() == TCPOptions::MAX_LENGTH, "options should fill the option space");
+            header.doff = (TCPHeader::LENGTH + header.options.length()) / 4;
+
+            const string bytes = header.serialize();
+            check(bytes.size() == TCPHeader::LENGTH + TCPOptions::MAX_LENGTH, "wrong serialized length");
+            const TCPHeader parsed = parse_header(bytes);
+            check(parsed == header, "decoded options did not round-trip: " + parsed.options.to_string());
+            check(parsed.serialize() == bytes, "re-serialized header differs");
+        }
+
+        // options we don't decode are kept byte-for-byte, as is a known option with a bad length
+        {
+            TCPHeader header;
+            header.doff = 9;
+            string bytes = header.serialize().substr(0, TCPHeader::LENGTH);
+            bytes += string("\x02\x04\x05\xb4", 4);          // MSS 1460
+            bytes += string("\x1e\x06\xaa\xbb\xcc\xdd", 6);  // kind 30, unknown
+            bytes += string("\x03\x04\x07\x00", 4);          // window scale with the wrong length
+            bytes += string("\x00\x00", 2);                  // End of Option List
+
+            const TCPHeader parsed = parse_header(bytes);
+            check(parsed.options.mss == 1460, "MSS not decoded");
+            check(not parsed.options.window_scale, "malformed window scale should not be decoded");
+            check(parsed.options.unknown_length == 10, "unknown options not kept");
+            check(parsed.serialize() == bytes, "unknown options did not round-trip");
+        }
+
+        // a malformed option ends parsing but doesn't make the header unparseable
+        {
+            TCPHeader header;
+            header.doff = 7;
+            string bytes = header.serialize().substr(0, TCPHeader::LENGTH);
+            bytes += string("\x01\x04\x02\x04\x05\xb4", 6);  // NOP, SACK-permitted, then MSS
+            bytes += string("\x1e\x30", 2);                  // runs past the end
+            const TCPHeader parsed = parse_header(bytes);
+            check(parsed.options.sack_permitted, "SACK-permitted not decoded");
+            check(not parsed.options.mss, "MSS after a bad length byte should not be decoded");
+        }
+
+        // a 5-word header has no options, and setting doff to 5 strips them
+        {
+            TCPHeader header;
+            header.options.mss = 536;
+            header.options.sack_permitted = true;
+            const string bytes = header.serialize();
+            check(bytes.size() == TCPHeader::LENGTH, "options written without room for them");
+            check(parse_header(bytes).options.empty(), "options parsed from a 5-word header");
+        }
+
+        // timestamps leave room for three SACK blocks
+        {
+            TCPOptions options;
+            check(options.sack_room() == TCPOptions::MAX_SACK_BLOCKS, "wrong SACK room");
+            options.timestamps = TCPTimestamps{1, 2};
+            check(options.length() == TCPOptions::TIMESTAMPS_SPACE, "wrong space for timestamps");
+            check(options.sack_room() == 3, "wrong SACK room with timestamps");
+            options.num_sack_blocks = 3;
+            check(options.length() == TCPOptions::MAX_LENGTH, "three SACK blocks and timestamps should fill the space");
+
+            // and fewer when the payload leaves less of the option space free
+            options.num_sack_blocks = 0;
+            check(options.sack_room(24) == 1, "wrong SACK room in 24 bytes");
+            check(options.sack_room(23) == 0, "the padding should count against the limit");
+            check(options.sack_room(0) == 0, "no room should fit no SACK blocks");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
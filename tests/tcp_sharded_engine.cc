@@ -0,0 +1,242 @@
+#include "address.hh"
+#include "buffer.hh"
+#include "parser.hh"
+#include "spsc_queue.hh"
+#include "tcp_config.hh"
+#include "tcp_engine.hh"
+#include "tcp_sharded_engine.hh"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+// the verification suite in Microsoft's RSS specification: source, destination, and the IPv4 + TCP hash
+struct HashVector {
+    string source;
+    uint16_t sport;
+    string destination;
+    uint16_t dport;
+    uint32_t hash;
+};
+
+static const vector<HashVector> HASH_VECTORS = {{"66.9.149.187", 2794, "161.142.100.80", 1766, 0x51ccc178},
+                                                {"199.92.111.2", 14230, "65.69.140.83", 4739, 0xc626b0ea},
+                                                {"24.19.198.95", 12898, "12.22.207.184", 38024, 0x5c2b394a},
+                                                {"38.27.205.30", 48228, "209.142.163.6", 2217, 0xafc7327f},
+                                                {"153.39.163.191", 44251, "202.188.127.2", 1303, 0x10e828a2}};
+
+static const Address CLIENT{"10.0.0.1"};
+static const Address SERVER{"10.0.0.2", 80};
+constexpr size_t CONNECTIONS = 64;
+constexpr size_t BYTES_EACH = 20000;
+
+// each client connection sends a letter chosen by its port, over and over
+static char letter(const uint16_t port) { return static_cast<char>('a' + port % 26); }
+
+// what a shard's handler keeps: only ever touched on that shard's thread
+struct Outbound {
+    TCPEngine::ConnectionId id = 0;
+    uint16_t port = 0;
+    size_t remaining = BYTES_EACH;
+};
+
+struct Inbound {
+    TCPEngine::ConnectionId id = 0;
+    bool done = false;
+};
+
+// copies a datagram through its wire format, as a TUN device would
+static InternetDatagram reparse(const InternetDatagram &dgram) {
+    InternetDatagram copy;
+    check(copy.parse(Buffer(dgram.serialize().concatenate())) == ParseResult::NoError, "datagrams should parse");
+    return copy;
+}
+
+int main() {
+    try {
+        // the hash matches a NIC's, for datagrams arriving from `source`
+        for (const HashVector &v : HASH_VECTORS) {
+            const TCPFourTuple tuple{
+                Address{v.destination}.ipv4_numeric(), v.dport, Address{v.source}.ipv4_numeric(), v.sport};
+            check(ShardedTCPEngine::toeplitz_hash(tuple) == v.hash, "Toeplitz hash mismatch for " + v.source);
+        }
+
+        {
+            // the queue is bounded, FIFO, and refuses what doesn't fit
+            SPSCQueue<string> queue{3};
+            check(queue.capacity() == 4, "capacity should round up to a power of two");
+            for (const string s : {"a", "b", "c", "d"}) {
+                check(queue.push(string(s)), "the queue should take four");
+            }
+            string rejected = "e";
+            check(not queue.push(move(rejected)) and rejected == "e", "a full queue should refuse, untouched");
+            string value;
+            check(queue.pop(value) and value == "a", "pop should return the oldest");
+            check(queue.push(string("e")) and queue.size() == 4, "a popped slot should be reused");
+            for (const string s : {"b", "c", "d", "e"}) {
+                check(queue.pop(value) and value == s, "the order should be kept across the wrap");
+            }
+            check(not queue.pop(value) and queue.empty(), "an empty queue should have nothing to pop");
+        }
+
+        {
+            // and hands everything across between two threads, in order
+            constexpr uint64_t COUNT = 1000000;
+            SPSCQueue<uint64_t> queue{256};
+            thread producer([&] {
+                for (uint64_t i = 0; i < COUNT; i++) {
+                    uint64_t value = i;
+                    while (not queue.push(move(value))) {
+                        this_thread::yield();
+                    }
+                }
+            });
+            uint64_t expected = 0;
+            uint64_t value = 0;
+            while (expected < COUNT) {
+                if (queue.pop(value)) {
+                    check(value == expected++, "values should arrive in order");
+                } else {
+                    this_thread::yield();
+                }
+            }
+            producer.join();
+        }
+
+        {
+            // idle workers sleep rather than spin, and a posted task wakes one straight away
+            ShardedTCPEngine idle{4};
+            const clock_t before = clock();
+            this_thread::sleep_for(chrono::milliseconds(500));
+            const double cpu_ms = 1000.0 * double(clock() - before) / CLOCKS_PER_SEC;
+            check(cpu_ms < 100, "idle workers used " + to_string(cpu_ms) + " ms of CPU in 500 ms");
+
+            atomic<bool> ran{false};
+            const auto posted = chrono::steady_clock::now();
+            check(idle.post(0, [&](TCPEngine &) { ran = true; }), "the task queue should have room");
+            while (not ran and chrono::steady_clock::now() < posted + chrono::seconds(5)) {
+                this_thread::yield();
+            }
+            check(ran and chrono::steady_clock::now() < posted + chrono::milliseconds(100),
+                  "a posted task should wake its worker");
+        }
+
+        {
+            // connections spread over the shards of both engines, and all their data arrives
+            const TCPConfig cfg{};
+            const size_t client_shards = 2, server_shards = 3;
+
+            vector<vector<Outbound>> outbound(client_shards);
+            ShardedTCPEngine client{client_shards, [&](const size_t shard, TCPEngine &engine) {
+                                        for (Outbound &conn : outbound[shard]) {
+                                            if (conn.remaining == 0) {
+                                                continue;
+                                            }
+                                            const string chunk(min<size_t>(conn.remaining, 4000), letter(conn.port));
+                                            conn.remaining -= engine.write(conn.id, chunk);
+                                            if (conn.remaining == 0) {
+                                                engine.release(conn.id);
+                                            }
+                                        }
+                                    }};
+
+            vector<vector<Inbound>> inbound(server_shards);
+            vector<vector<TCPFourTuple>> accepted(server_shards);
+            atomic<uint64_t> received{0};
+            atomic<size_t> finished{0};
+            atomic<bool> corrupt{false};
+            ShardedTCPEngine server{server_shards, [&](const size_t shard, TCPEngine &engine) {
+                                        while (const auto id = engine.accept(SERVER.port())) {
+                                            inbound[shard].push_back({*id, false});
+                                            accepted[shard].push_back(engine.four_tuple(*id));
+                                        }
+                                        for (Inbound &conn : inbound[shard]) {
+                                            if (conn.done) {
+                                                continue;
+                                            }
+                                            ByteStream &stream = engine.connection(conn.id).inbound_stream();
+                                            const string data = stream.read(stream.buffer_size());
+                                            const char expected = letter(engine.four_tuple(conn.id).remote_port);
+                                            if (data.find_first_not_of(expected) != string::npos) {
+                                                corrupt = true;
+                                            }
+                                            received += data.size();
+                                            if (stream.eof()) {
+                                                conn.done = true;
+                                                finished++;
+                                                engine.release(conn.id);
+                                            }
+                                        }
+                                    }};
+            server.listen(cfg, SERVER);
+
+            vector<size_t> connected(client_shards);
+            for (size_t i = 0; i < CONNECTIONS; i++) {
+                const Address local{CLIENT.ip(), static_cast<uint16_t>(40000 + i)};
+                const TCPFourTuple tuple{local.ipv4_numeric(), local.port(), SERVER.ipv4_numeric(), SERVER.port()};
+                const size_t shard = client.shard_of(tuple);
+                connected[shard]++;
+                check(client.post(shard,
+                                  [&, shard, local](TCPEngine &engine) {
+                                      outbound[shard].push_back({engine.connect(cfg, local, SERVER), local.port()});
+                                  }),
+                      "the task queue should have room");
+            }
+            check(connected[0] > 0 and connected[1] > 0, "the client's connections should use both shards");
+
+            // this thread is the wire between the two, and the ingress and egress of both
+            const auto deadline = chrono::steady_clock::now() + chrono::seconds(30);
+            vector<InternetDatagram> datagrams;
+            while (finished < CONNECTIONS and chrono::steady_clock::now() < deadline) {
+                datagrams.clear();
+                client.datagrams_out(datagrams);
+                for (const InternetDatagram &dgram : datagrams) {
+                    server.datagram_received(reparse(dgram));
+                }
+                const bool idle = datagrams.empty();
+                datagrams.clear();
+                server.datagrams_out(datagrams);
+                for (const InternetDatagram &dgram : datagrams) {
+                    client.datagram_received(reparse(dgram));
+                }
+                if (idle and datagrams.empty()) {
+                    this_thread::yield();
+                }
+            }
+            client.stop();
+            server.stop();
+
+            check(finished == CONNECTIONS, "every connection should finish");
+            check(received == CONNECTIONS * BYTES_EACH, "every byte should arrive");
+            check(not corrupt, "each connection should only carry its own data");
+            for (size_t shard = 0; shard < server_shards; shard++) {
+                check(not accepted[shard].empty(), "every server shard should own some connections");
+                for (const TCPFourTuple &tuple : accepted[shard]) {
+                    check(server.shard_of(tuple) == shard, "a connection should live on the shard it hashes to");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
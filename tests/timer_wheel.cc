@@ -0,0 +1,117 @@
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void check(const bool ok, const string &what) {
+    if (not ok) {
+        throw runtime_error(what);
+    }
+}
+
+static vector<TimerWheel::Key> expire(TimerWheel &wheel, const uint64_t now) {
+    vector<TimerWheel::Key> expired;
+    wheel.advance(now, expired);
+    return expired;
+}
+
+int main() {
+    try {
+        {
+            TimerWheel wheel;
+            check(wheel.empty() and not wheel.next_deadline(), "a new wheel should have no deadlines");
+            wheel.schedule(1, 10);
+            wheel.schedule(2, 5);
+            wheel.schedule(3, 100000);
+            check(wheel.size() == 3 and wheel.next_deadline() == 5u, "the earliest deadline should be 5");
+            check(expire(wheel, 4).empty(), "nothing should expire before 5");
+            check(expire(wheel, 5) == vector<TimerWheel::Key>{2}, "key 2 should expire at 5");
+            check(wheel.next_deadline() == 10u, "the next deadline should be 10");
+
+            // moving and cancelling deadlines
+            wheel.schedule(1, 20);
+            check(expire(wheel, 19).empty(), "key 1 should have moved to 20");
+            wheel.cancel(1);
+            check(expire(wheel, 30).empty(), "key 1 should have been cancelled");
+            check(wheel.deadline(3) == 100000u and not wheel.deadline(1), "only key 3 should be left");
+
+            // a deadline far ahead comes down the wheel to expire on time
+            check(expire(wheel, 99999).empty(), "key 3 shouldn't expire early");
+            check(wheel.next_deadline() == 100000u, "key 3 should be next, exactly");
+            check(expire(wheel, 100000) == vector<TimerWheel::Key>{3}, "key 3 should expire at 100000");
+            check(wheel.empty() and not wheel.next_deadline(), "the wheel should be empty");
+
+            // a deadline in the past expires at once
+            wheel.schedule(4, 50);
+            check(expire(wheel, 100000) == vector<TimerWheel::Key>{4}, "a past deadline should expire");
+            wheel.schedule(5, uint64_t{1} << 60);
+            check(expire(wheel, (uint64_t{1} << 60) - 1).empty(), "a deadline beyond the top level should wait");
+            check(expire(wheel, uint64_t{1} << 60) == vector<TimerWheel::Key>{5}, "and expire on time");
+        }
+
+        // against a reference, with random deadlines, cancellations and steps
+        auto rd = get_random_generator();
+        for (unsigned round = 0; round < 20; round++) {
+            TimerWheel wheel;
+            map<TimerWheel::Key, uint64_t> reference;
+            uint64_t now = rd() % 1000000;
+            expire(wheel, now);
+            const uint64_t horizon = uint64_t{1} << (rd() % 30);
+
+            for (unsigned step = 0; step < 5000; step++) {
+                const TimerWheel::Key key = rd() % 200;
+                switch (rd() % 4) {
+                    case 0:
+                    case 1: {
+                        const uint64_t deadline = now + rd() % horizon;
+                        wheel.schedule(key, deadline);
+                        reference[key] = deadline;
+                        break;
+                    }
+                    case 2:
+                        wheel.cancel(key);
+                        reference.erase(key);
+                        break;
+                    default: {
+                        now += rd() % (horizon / 8 + 2);
+                        const vector<TimerWheel::Key> expired = expire(wheel, now);
+                        uint64_t last = 0;
+                        for (const TimerWheel::Key k : expired) {
+                            check(reference.count(k) and reference[k] <= now, "a key expired early");
+                            check(reference[k] >= last, "keys expired out of order");
+                            last = reference[k];
+                            reference.erase(k);
+                        }
+                        for (const auto &[k, deadline] : reference) {
+                            check(deadline > now, "key " + to_string(k) + " didn't expire");
+                        }
+                        break;
+                    }
+                }
+                check(wheel.size() == reference.size(), "the wheel lost track of a key");
+                if (not reference.empty()) {
+                    uint64_t earliest = UINT64_MAX;
+                    for (const auto &entry : reference) {
+                        earliest = min(earliest, entry.second);
+                    }
+                    check(wheel.next_deadline() <= earliest, "next_deadline() is too late");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -11,6 +11,13 @@
 
 using namespace std;
 
+// the comparisons and offsets are constexpr
+static_assert(WrappingInt32(3) != WrappingInt32(1));
+static_assert(WrappingInt32(UINT32_MAX) + 2 == WrappingInt32(1));
+static_assert(WrappingInt32(1) - 2u == WrappingInt32(UINT32_MAX));
+static_assert(WrappingInt32(1) - WrappingInt32(UINT32_MAX) == 2);
+static_assert(WrappingInt32(UINT32_MAX) - WrappingInt32(1) == -2);
+
 int main() {
     try {
         // Comparing low-number adjacent seqnos
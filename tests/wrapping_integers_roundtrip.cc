@@ -5,6 +5,7 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
@@ -42,6 +43,27 @@ int main() {
             check_roundtrip(isn, val + big_offset, val);
             check_roundtrip(isn, val - big_offset, val);
         }
+
+        // the batched unwrap agrees with unwrapping one at a time
+        vector<WrappingInt32> seqnos;
+        vector<uint64_t> unwrapped;
+        for (unsigned int i = 0; i < 1000; i++) {
+            const WrappingInt32 isn{dist32(rd)};
+            const uint64_t checkpoint{dist63(rd)};
+            seqnos.clear();
+            for (unsigned int j = 0; j < i % 64; j++) {
+                seqnos.emplace_back(dist32(rd));
+            }
+            unwrap(seqnos, isn, checkpoint, unwrapped);
+            if (unwrapped.size() != seqnos.size()) {
+                throw runtime_error("batched unwrap returned the wrong number of seqnos");
+            }
+            for (size_t j = 0; j < seqnos.size(); j++) {
+                if (unwrapped[j] != unwrap(seqnos[j], isn, checkpoint)) {
+                    throw runtime_error("batched unwrap disagreed with unwrap");
+                }
+            }
+        }
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return 1;
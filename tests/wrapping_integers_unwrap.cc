@@ -9,6 +9,23 @@
 
 using namespace std;
 
+// unwrap() is constexpr, so the same cases (and the edges of the checkpoint's range) are checked at
+// compile time
+static_assert(unwrap(WrappingInt32(1), WrappingInt32(0), 0) == 1);
+static_assert(unwrap(WrappingInt32(1), WrappingInt32(0), UINT32_MAX) == (1ul << 32) + 1);
+static_assert(unwrap(WrappingInt32(UINT32_MAX - 1), WrappingInt32(0), 3 * (1ul << 32)) == 3 * (1ul << 32) - 2);
+static_assert(unwrap(WrappingInt32(UINT32_MAX - 10), WrappingInt32(0), 3 * (1ul << 32)) == 3 * (1ul << 32) - 11);
+static_assert(unwrap(WrappingInt32(UINT32_MAX), WrappingInt32(10), 3 * (1ul << 32)) == 3 * (1ul << 32) - 11);
+static_assert(unwrap(WrappingInt32(UINT32_MAX), WrappingInt32(0), 0) == UINT32_MAX);
+static_assert(unwrap(WrappingInt32(16), WrappingInt32(16), 0) == 0);
+static_assert(unwrap(WrappingInt32(15), WrappingInt32(16), 0) == UINT32_MAX);
+static_assert(unwrap(WrappingInt32(0), WrappingInt32(INT32_MAX), 0) == static_cast<uint64_t>(INT32_MAX) + 2);
+static_assert(unwrap(WrappingInt32(UINT32_MAX), WrappingInt32(INT32_MAX), 0) == uint64_t{1} << 31);
+static_assert(unwrap(WrappingInt32(UINT32_MAX), WrappingInt32(1ul << 31), 0) == UINT32_MAX >> 1);
+static_assert(unwrap(WrappingInt32(0), WrappingInt32(0), (1ul << 32) + (1ul << 31) - 1) == 1ul << 32);
+static_assert(unwrap(WrappingInt32(0), WrappingInt32(0), (1ul << 32) + (1ul << 31)) == 1ul << 32);
+static_assert(unwrap(WrappingInt32(0), WrappingInt32(0), (1ul << 32) + (1ul << 31) + 1) == 2ul << 32);
+
 int main() {
     try {
         // Unwrap the first byte after ISN
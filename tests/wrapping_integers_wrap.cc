@@ -10,6 +10,11 @@
 
 using namespace std;
 
+// wrap() is constexpr, so the same cases are checked at compile time
+static_assert(wrap(3 * (1ull << 32), WrappingInt32(0)) == WrappingInt32(0));
+static_assert(wrap(3 * (1ull << 32) + 17, WrappingInt32(15)) == WrappingInt32(32));
+static_assert(wrap(7 * (1ull << 32) - 2, WrappingInt32(15)) == WrappingInt32(13));
+
 int main() {
     try {
         test_should_be(wrap(3 * (1ll << 32), WrappingInt32(0)), WrappingInt32(0));